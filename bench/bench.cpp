@@ -0,0 +1,238 @@
+#include "lib/DB_controller.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t kBatchRows = 1024;
+static constexpr size_t kStatements = 10000;
+
+struct Result {
+    std::string name;
+    size_t rows = 0;
+    double selectivity = 0;
+    size_t items = 0;
+    std::vector<double> latencies;
+};
+
+static double Seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static size_t PeakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_maxrss;
+}
+
+static size_t RssKb() {
+    size_t pages = 0;
+    size_t resident = 0;
+    if (FILE* file = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(file, "%zu %zu", &pages, &resident) != 2)
+            resident = 0;
+        std::fclose(file);
+    }
+
+    return resident * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+static std::vector<std::string> Split(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    for (std::string item; std::getline(stream, item, ',');) {
+        items.emplace_back(item);
+    }
+
+    return items;
+}
+
+static size_t Drain(DB::Cursor cursor) {
+    size_t lines = 0;
+    for (std::string line; cursor.Next(line);) {
+        ++lines;
+    }
+
+    return lines;
+}
+
+// Reads the row count out of an "-- UPDATED n ROWS --" style message.
+static size_t Affected(const std::string& message) {
+    size_t digit = message.find_first_of("0123456789");
+
+    return digit == std::string::npos ? 0 : std::stoul(message.substr(digit));
+}
+
+// Times body once per repetition; body returns the number of items (rows, statements) it handled.
+template <typename Body>
+static Result Measure(const std::string& name, size_t rows, double selectivity, size_t repeats, Body body) {
+    Result result;
+    result.name = name;
+    result.rows = rows;
+    result.selectivity = selectivity;
+    for (size_t i = 0; i < repeats; ++i) {
+        auto start = Clock::now();
+        result.items += body(i);
+        result.latencies.emplace_back(Seconds(start));
+    }
+
+    return result;
+}
+
+static double Percentile(const std::vector<double>& sorted, double percent) {
+    size_t rank = std::max<size_t>(1, static_cast<size_t>(percent / 100 * sorted.size() + 0.999999));
+
+    return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+static void Print(std::ostream& out, const Result& result, bool last) {
+    std::vector<double> sorted = result.latencies;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0;
+    for (auto latency : sorted) {
+        total += latency;
+    }
+    out << "    {\"name\": \"" << result.name << "\", \"rows\": " << result.rows << ", \"selectivity\": "
+        << result.selectivity << ", \"ops\": " << sorted.size() << ", \"seconds\": " << total
+        << ", \"ops_per_sec\": " << sorted.size() / total << ", \"items\": " << result.items
+        << ", \"items_per_sec\": " << result.items / total << ", \"latency_us\": {\"p50\": "
+        << Percentile(sorted, 50) * 1e6 << ", \"p90\": " << Percentile(sorted, 90) * 1e6 << ", \"p99\": "
+        << Percentile(sorted, 99) * 1e6 << ", \"max\": " << sorted.back() * 1e6 << "}, \"rss_kb\": " << RssKb()
+        << ", \"peak_rss_kb\": " << PeakRssKb() << "}" << (last ? "" : ",") << std::endl;
+}
+
+static std::vector<std::string> MakeRow(std::mt19937_64& random, size_t id) {
+    return {std::to_string(id), std::to_string(random() % 1000), std::to_string(random() % 100000 / 100.0),
+            "name" + std::to_string(random() % 100000)};
+}
+
+static Result BenchParse(size_t repeats) {
+    std::vector<std::string> inputs;
+    for (size_t i = 0; i < kStatements; ++i) {
+        inputs.emplace_back("SELECT id, name FROM t WHERE a < " + std::to_string(i % 1000) + " AND name = 'n" +
+                            std::to_string(i) + "' OR x >= 1.5 ORDER BY x DESC LIMIT 10;");
+    }
+
+    return Measure("parse", 0, 0, repeats, [&](size_t) {
+        for (auto& input : inputs) {
+            DB::Statement statement;
+            DB::Parser parser(input);
+            parser.Parse(statement);
+            DB::Parser::Compile(std::move(statement));
+        }
+        return inputs.size();
+    });
+}
+
+static Result BenchReadInput(size_t repeats) {
+    DB::MyAwesomeDB db;
+    std::ostream null(nullptr);
+    DB::Controller controller(db, null);
+    controller.ReadInput("CREATE TABLE r (id INT, a INT, x DOUBLE, name TEXT, PRIMARY KEY(id));");
+    std::mt19937_64 random(7);
+    size_t id = 0;
+
+    return Measure("read_input_insert", 0, 0, repeats, [&](size_t) {
+        for (size_t i = 0; i < kStatements; ++i, ++id) {
+            auto row = MakeRow(random, id);
+            controller.ReadInput("INSERT INTO r (id, a, x, name) VALUES (" + row[0] + ", " + row[1] + ", " + row[2] +
+                                 ", '" + row[3] + "');");
+        }
+        return kStatements;
+    });
+}
+
+static void BenchTables(std::vector<Result>& results, size_t rows, const std::vector<double>& selectivities,
+                        size_t repeats, size_t threads) {
+    DB::MyAwesomeDB db;
+    db.SetParallelism(threads);
+    db.CreateTable("t", {{"id", "INT"}, {"a", "INT"}, {"x", "DOUBLE"}, {"name", "TEXT"}}, "id");
+    db.CreateTable("u", {{"uid", "INT"}, {"ref", "INT"}, {"y", "DOUBLE"}}, "uid");
+    std::mt19937_64 random(42);
+    std::vector<std::vector<std::string>> batch;
+    results.emplace_back(Measure("insert_batch", rows, 1, (rows + kBatchRows - 1) / kBatchRows, [&](size_t i) {
+        batch.clear();
+        for (size_t id = i * kBatchRows; id < std::min(rows, (i + 1) * kBatchRows); ++id) {
+            batch.emplace_back(MakeRow(random, id));
+        }
+        db.Insert("t", {"id", "a", "x", "name"}, batch);
+        return batch.size();
+    }));
+    for (size_t id = 0; id < rows / 4; ++id) {
+        batch.push_back({std::to_string(id), std::to_string(random() % rows), std::to_string(random() % 1000)});
+        if (batch.size() == kBatchRows || id + 1 == rows / 4) {
+            db.Insert("u", {"uid", "ref", "y"}, batch);
+            batch.clear();
+        }
+    }
+
+    for (auto selectivity : selectivities) {
+        std::string bound = std::to_string(static_cast<int64_t>(selectivity * 1000));
+        std::vector<std::vector<DB::Condition>> where = {{DB::Condition("<", "a", bound)}};
+        std::vector<std::vector<DB::Condition>> joined_where = {{DB::Condition("<", "t.a", bound)}};
+        std::vector<std::vector<DB::Condition>> join_on = {{DB::Condition("=", "t.id", "u.ref")}};
+        results.emplace_back(Measure("get_rows", rows, selectivity, repeats, [&](size_t) {
+            return db.GetRows("t", where).Count();
+        }));
+        results.emplace_back(Measure("select_output", rows, selectivity, repeats, [&](size_t) {
+            return Drain(db.Select("t", {"id", "a", "x", "name"}, where));
+        }));
+        results.emplace_back(Measure("inner_join", rows, selectivity, repeats, [&](size_t) {
+            return Drain(db.SelectJoined("t", "u", "INNER", join_on, {"t.id", "t.a", "u.y"}, joined_where));
+        }));
+        results.emplace_back(Measure("left_join", rows, selectivity, repeats, [&](size_t) {
+            return Drain(db.SelectJoined("t", "u", "LEFT", join_on, {"t.id", "t.a", "u.y"}, joined_where));
+        }));
+        results.emplace_back(Measure("update", rows, selectivity, repeats, [&](size_t i) {
+            return Affected(db.Update("t", {{"x", std::to_string(i)}}, where));
+        }));
+    }
+    // Every repetition deletes its own id slice so later ones still find rows.
+    size_t slice = rows / selectivities.size() / repeats;
+    for (size_t s = 0; s < selectivities.size(); ++s) {
+        std::string bound = std::to_string(static_cast<int64_t>(selectivities[s] * 1000));
+        size_t first = slice * repeats * s;
+        results.emplace_back(Measure("delete", rows, selectivities[s], repeats, [&](size_t i) {
+            return Affected(db.Delete("t", {{DB::Condition(">=", "id", std::to_string(first + i * slice)),
+                                             DB::Condition("<", "id", std::to_string(first + (i + 1) * slice)),
+                                             DB::Condition("<", "a", bound)}}));
+        }));
+    }
+}
+
+// Usage: bench [rows[,rows...]] [selectivity[,selectivity...]] [repeats] [threads]
+// Prints one JSON document with a result per operation, table size and selectivity.
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes;
+    for (auto& item : Split(argc > 1 ? argv[1] : "100000,1000000")) {
+        sizes.emplace_back(std::stoul(item));
+    }
+    std::vector<double> selectivities;
+    for (auto& item : Split(argc > 2 ? argv[2] : "0.01,0.1,0.5")) {
+        selectivities.emplace_back(std::stod(item));
+    }
+    size_t repeats = argc > 3 ? std::stoul(argv[3]) : 10;
+    size_t threads = argc > 4 ? std::stoul(argv[4]) : std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<Result> results;
+    results.emplace_back(BenchParse(repeats));
+    results.emplace_back(BenchReadInput(repeats));
+    for (auto rows : sizes) {
+        BenchTables(results, rows, selectivities, repeats, threads);
+    }
+
+    std::cout << "{\n  \"threads\": " << threads << ",\n  \"repeats\": " << repeats << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        Print(std::cout, results[i], i + 1 == results.size());
+    }
+    std::cout << "  ],\n  \"peak_rss_kb\": " << PeakRssKb() << "\n}" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "lib/database.h"
+#include "lib/kernels.h"
+
+#include <chrono>
+#include <random>
+
+using Clock = std::chrono::steady_clock;
+
+static const char* kKernels[] = {"scalar", "sse4.2", "avx2"};
+
+static double Seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void Report(const std::string& name, size_t bytes, int repeats, double seconds) {
+    std::cout << name << "\t" << DB::KernelName() << "\t" << bytes * repeats / seconds / 1e9 << " GB/s" << std::endl;
+}
+
+static void BenchKernels(size_t rows, int repeats) {
+    std::mt19937_64 random(42);
+    std::vector<int64_t> ints(rows);
+    std::vector<int64_t> other_ints(rows);
+    std::vector<double> doubles(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        ints[i] = random() % 1000;
+        other_ints[i] = random() % 1000;
+        doubles[i] = (random() % 100000) / 100.0;
+    }
+    std::vector<uint64_t> out((rows + 63) / 64);
+    auto start = Clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        DB::CompareInts(DB::LESS, ints.data(), nullptr, 500, rows, out.data());
+    }
+    Report("int < constant   ", rows * sizeof(int64_t), repeats, Seconds(start));
+    start = Clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        DB::CompareInts(DB::LESS_EQUAL, ints.data(), other_ints.data(), 0, rows, out.data());
+    }
+    Report("int <= int       ", rows * sizeof(int64_t) * 2, repeats, Seconds(start));
+    start = Clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        DB::CompareDoubles(DB::GREATER_EQUAL, doubles.data(), nullptr, 250.5, rows, out.data());
+    }
+    Report("double >= constant", rows * sizeof(double), repeats, Seconds(start));
+}
+
+static void Populate(DB::MyAwesomeDB& db, size_t rows) {
+    db.CreateTable("bench", {{"id", "INT"}, {"a", "INT"}, {"x", "DOUBLE"}}, "id");
+    std::mt19937_64 random(42);
+    std::vector<std::vector<std::string>> values;
+    for (size_t i = 0; i < rows; ++i) {
+        values.push_back({std::to_string(i), std::to_string(random() % 1000), std::to_string(random() % 1000 / 4.0)});
+        if (values.size() == 65536 || i + 1 == rows) {
+            db.Insert("bench", {"id", "a", "x"}, values);
+            values.clear();
+        }
+    }
+}
+
+static void BenchQuery(DB::MyAwesomeDB& db, size_t rows, int repeats) {
+    std::vector<std::vector<DB::Condition>> conditions = {{DB::Condition("<", "a", "500"),
+                                                           DB::Condition(">=", "x", "100")},
+                                                          {DB::Condition("=", "a", "7")}};
+    size_t selected = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        selected = db.GetRows("bench", conditions).Count();
+    }
+    Report("WHERE (a < 500 AND x >= 100) OR a = 7", rows * (sizeof(int64_t) + sizeof(double)), repeats,
+           Seconds(start));
+    std::cout << "  " << selected << " of " << rows << " rows selected, " << db.parallelism() << " threads"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::stoul(argv[1]) : 1 << 22;
+    int repeats = argc > 2 ? std::stoi(argv[2]) : 20;
+    DB::MyAwesomeDB db;
+    Populate(db, rows);
+    for (auto kernels : kKernels) {
+        if (!DB::UseKernels(kernels))
+            continue;
+        BenchKernels(rows, repeats);
+        BenchQuery(db, rows, repeats);
+    }
+
+    return 0;
+}
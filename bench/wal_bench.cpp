@@ -0,0 +1,76 @@
+#include "lib/database.h"
+#include "lib/wal.h"
+
+#include <chrono>
+#include <cstdio>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+static const char* kModes[] = {"fsync", "group", "buffered"};
+
+static double Seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void BenchInserts(const std::string& path, DB::Durability durability, int rows) {
+    unlink(path.c_str());
+    DB::MyAwesomeDB db;
+    std::string message;
+    if (!db.Open(path, durability, message)) {
+        std::cout << message << std::endl;
+        return;
+    }
+    db.CreateTable("bench", {{"id", "int"}, {"name", "text"}, {"score", "double"}}, "id");
+    auto start = Clock::now();
+    for (int i = 0; i < rows; ++i) {
+        db.Insert("bench", {"id", "name", "score"}, {{std::to_string(i), "name" + std::to_string(i),
+                                                      std::to_string(i * 0.5)}});
+    }
+    double seconds = Seconds(start);
+    std::cout << "insert    " << kModes[durability] << "\t" << rows << " rows\t" << seconds << " s\t"
+              << rows / seconds << " rows/s" << std::endl;
+}
+
+static void BenchCommits(const std::string& path, DB::Durability durability, int threads, int commits) {
+    unlink(path.c_str());
+    DB::WriteAheadLog log;
+    std::vector<DB::LogRecord> records;
+    if (!log.Open(path, durability, records))
+        return;
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&log, t, commits] {
+            for (int i = 0; i < commits; ++i) {
+                DB::LogRecord record(DB::LOG_INSERT);
+                record.PutString("bench");
+                record.PutStrings({"id"});
+                record.PutStrings({std::to_string(t * commits + i)});
+                log.Commit(log.Append(record));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double seconds = Seconds(start);
+    int total = threads * commits;
+    std::cout << "commit    " << kModes[durability] << "\t" << threads << " threads\t" << total << " commits\t"
+              << seconds << " s\t" << total / seconds << " commits/s" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "wal_bench.log";
+    int rows = argc > 2 ? std::stoi(argv[2]) : 2000;
+    int threads = argc > 3 ? std::stoi(argv[3]) : 8;
+    for (auto durability : {DB::FSYNC_EACH, DB::GROUP_COMMIT, DB::OS_BUFFERED}) {
+        BenchInserts(path, durability, rows);
+    }
+    for (auto durability : {DB::FSYNC_EACH, DB::GROUP_COMMIT, DB::OS_BUFFERED}) {
+        BenchCommits(path, durability, threads, rows / threads);
+    }
+    unlink(path.c_str());
+
+    return 0;
+}
@@ -0,0 +1,273 @@
+#include "lib/protocol.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct Connection {
+    int fd = -1;
+    std::string input;
+    std::string output;
+    size_t sent = 0;
+    size_t issued = 0;
+    std::deque<Clock::time_point> started;
+};
+
+static int Connect(const std::string& host, int port, const std::string& socket_path) {
+    int fd;
+    if (!socket_path.empty()) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(address.sun_path))
+            return -1;
+        std::memcpy(address.sun_path, socket_path.data(), socket_path.size());
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+            return fd;
+    } else {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+            return -1;
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int one = 1;
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 &&
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) == 0)
+            return fd;
+    }
+    if (fd >= 0)
+        close(fd);
+
+    return -1;
+}
+
+static bool SendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t size = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (size < 0 && errno == EINTR)
+            continue;
+        if (size <= 0)
+            return false;
+        sent += size;
+    }
+
+    return true;
+}
+
+static bool Interactive(int fd) {
+    std::string input;
+    std::string line;
+    std::string buffer;
+    char chunk[64 << 10];
+    while (true) {
+        while (input.find(';') >= input.size()) {
+            if (!std::getline(std::cin, line) || line == "STOP")
+                return true;
+            input += line;
+        }
+        std::string frame;
+        DB::PutFrame(frame, DB::FRAME_QUERY, input);
+        input = "";
+        if (!SendAll(fd, frame))
+            return false;
+        bool done = false;
+        while (!done) {
+            std::string_view view(buffer);
+            DB::FrameType type;
+            std::string_view payload;
+            bool bad;
+            while (!done && DB::GetFrame(view, type, payload, bad)) {
+                if (type == DB::FRAME_LINE)
+                    std::cout << payload << '\n';
+                done = type == DB::FRAME_END;
+            }
+            buffer.erase(0, buffer.size() - view.size());
+            if (bad)
+                return false;
+            if (done)
+                break;
+            ssize_t size = recv(fd, chunk, sizeof(chunk), 0);
+            if (size < 0 && errno == EINTR)
+                continue;
+            if (size <= 0)
+                return false;
+            buffer.append(chunk, size);
+        }
+        std::cout.flush();
+    }
+}
+
+static std::string MakeQuery(const std::string& pattern, size_t sequence) {
+    std::string query = pattern;
+    for (size_t at = query.find("$n"); at != std::string::npos; at = query.find("$n", at)) {
+        query.replace(at, 2, std::to_string(sequence));
+    }
+
+    return query;
+}
+
+static bool Flush(Connection& connection) {
+    while (connection.sent < connection.output.size()) {
+        ssize_t size = send(connection.fd, connection.output.data() + connection.sent,
+                            connection.output.size() - connection.sent, MSG_NOSIGNAL);
+        if (size > 0) {
+            connection.sent += size;
+            continue;
+        }
+        if (size < 0 && errno == EINTR)
+            continue;
+        return size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+    connection.output.clear();
+    connection.sent = 0;
+
+    return true;
+}
+
+static double Percentile(const std::vector<double>& sorted, double fraction) {
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+}
+
+static bool Load(std::vector<Connection>& connections, const std::vector<std::string>& queries, size_t requests,
+                 size_t pipeline) {
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    size_t sequence = 0;
+    size_t remaining = connections.size() * requests;
+    std::vector<double> latencies;
+    latencies.reserve(remaining);
+    auto issue = [&](Connection& connection) {
+        while (connection.issued < requests && connection.started.size() < pipeline) {
+            const std::string& pattern = queries[connection.issued % queries.size()];
+            DB::PutFrame(connection.output, DB::FRAME_QUERY, MakeQuery(pattern, sequence++));
+            connection.started.push_back(Clock::now());
+            ++connection.issued;
+        }
+    };
+    auto start = Clock::now();
+    for (size_t i = 0; i < connections.size(); ++i) {
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        event.data.u64 = i;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, connections[i].fd, &event);
+        issue(connections[i]);
+    }
+    epoll_event events[256];
+    char chunk[64 << 10];
+    while (remaining > 0) {
+        int count = epoll_wait(epoll, events, 256, -1);
+        for (int i = 0; i < count; ++i) {
+            Connection& connection = connections[events[i].data.u64];
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0) {
+                ssize_t size;
+                while ((size = recv(connection.fd, chunk, sizeof(chunk), 0)) > 0) {
+                    connection.input.append(chunk, size);
+                }
+                if (size == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    std::cout << "-- CONNECTION CLOSED BY SERVER --\n" << std::endl;
+                    return false;
+                }
+                std::string_view view(connection.input);
+                DB::FrameType type;
+                std::string_view payload;
+                bool bad;
+                while (DB::GetFrame(view, type, payload, bad)) {
+                    if (type != DB::FRAME_END)
+                        continue;
+                    auto latency = Clock::now() - connection.started.front();
+                    latencies.push_back(std::chrono::duration<double, std::micro>(latency).count());
+                    connection.started.pop_front();
+                    --remaining;
+                }
+                connection.input.erase(0, connection.input.size() - view.size());
+                if (bad)
+                    return false;
+                issue(connection);
+            }
+            if (!Flush(connection))
+                return false;
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    close(epoll);
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << latencies.size() << " statements over " << connections.size() << " connections, pipeline "
+              << pipeline << ": " << seconds << " s, " << latencies.size() / seconds << " statements/s" << std::endl;
+    std::cout << "latency us: p50 " << Percentile(latencies, 0.5) << ", p99 " << Percentile(latencies, 0.99)
+              << ", p99.9 " << Percentile(latencies, 0.999) << ", max " << latencies.back() << std::endl;
+
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::string host = "127.0.0.1";
+    std::string socket_path;
+    int port = 5480;
+    size_t connections = 1;
+    size_t requests = 1000;
+    size_t pipeline = 1;
+    std::vector<std::string> queries;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--host") {
+            host = argv[i + 1];
+        } else if (option == "--port" && std::atoi(argv[i + 1]) > 0) {
+            port = std::atoi(argv[i + 1]);
+        } else if (option == "--socket") {
+            socket_path = argv[i + 1];
+        } else if (option == "--connections" && std::atoi(argv[i + 1]) > 0) {
+            connections = std::atoi(argv[i + 1]);
+        } else if (option == "--requests" && std::atoi(argv[i + 1]) > 0) {
+            requests = std::atoi(argv[i + 1]);
+        } else if (option == "--pipeline" && std::atoi(argv[i + 1]) > 0) {
+            pipeline = std::atoi(argv[i + 1]);
+        } else if (option == "--query") {
+            queries.emplace_back(argv[i + 1]);
+        } else {
+            std::cout << "-- USAGE: " << argv[0] << " [--host ADDR] [--port N] [--socket PATH]"
+                      << " [--query SQL]... [--connections N] [--requests N] [--pipeline N] --\n" << std::endl;
+            return 1;
+        }
+    }
+    if (queries.empty()) {
+        int fd = Connect(host, port, socket_path);
+        if (fd < 0) {
+            std::cout << "-- CANNOT CONNECT --\n" << std::endl;
+            return 1;
+        }
+        bool finished = Interactive(fd);
+        close(fd);
+        return finished ? 0 : 1;
+    }
+    requests = (requests + queries.size() - 1) / queries.size() * queries.size();
+    std::vector<Connection> pool(connections);
+    for (auto& connection : pool) {
+        connection.fd = Connect(host, port, socket_path);
+        if (connection.fd < 0) {
+            std::cout << "-- CANNOT CONNECT --\n" << std::endl;
+            return 1;
+        }
+        fcntl(connection.fd, F_SETFL, fcntl(connection.fd, F_GETFL) | O_NONBLOCK);
+    }
+    bool finished = Load(pool, queries, requests, pipeline);
+    for (auto& connection : pool) {
+        close(connection.fd);
+    }
+
+    return finished ? 0 : 1;
+}
@@ -1,16 +1,37 @@
 #include "lib/DB_controller.h"
+#include "lib/wal.h"
 
-int main() {
+int main(int argc, char* argv[]) {
     DB::MyAwesomeDB db;
     DB::Controller controller(db);
     std::string input;
     std::string line;
+    std::string wal;
+    DB::Durability durability = DB::GROUP_COMMIT;
     bool flag = false;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--wal") {
+            wal = argv[i + 1];
+        } else if (option == "--threads" && std::atoi(argv[i + 1]) > 0) {
+            db.SetParallelism(std::atoi(argv[i + 1]));
+        } else if (option != "--durability" || !DB::WriteAheadLog::SeeDurability(argv[i + 1], durability)) {
+            std::cout << "-- USAGE: " << argv[0]
+                      << " [--wal PATH] [--durability fsync|group|buffered] [--threads N] --\n" << std::endl;
+            return 1;
+        }
+    }
+    if (!wal.empty()) {
+        std::string message;
+        bool opened = db.Open(wal, durability, message);
+        std::cout << message << std::endl;
+        if (!opened)
+            return 1;
+    }
     std::cout << "-- ENTER \"STOP\" TO STOP THE PROGRAM --\n" << std::endl;
     while (true) {
         while (input.find(';') >= input.size()) {
-            std::getline(std::cin, line);
-            if (line == "STOP") {
+            if (!std::getline(std::cin, line) || line == "STOP") {
                 flag = true;
                 break;
             }
@@ -0,0 +1,57 @@
+#include "lib/server.h"
+#include "lib/wal.h"
+
+#include <csignal>
+#include <pthread.h>
+
+int main(int argc, char* argv[]) {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    DB::MyAwesomeDB db;
+    std::string wal;
+    std::string socket;
+    int port = -1;
+    size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    DB::Durability durability = DB::GROUP_COMMIT;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--wal") {
+            wal = argv[i + 1];
+        } else if (option == "--port" && std::atoi(argv[i + 1]) >= 0) {
+            port = std::atoi(argv[i + 1]);
+        } else if (option == "--socket") {
+            socket = argv[i + 1];
+        } else if (option == "--workers" && std::atoi(argv[i + 1]) > 0) {
+            workers = std::atoi(argv[i + 1]);
+        } else if (option == "--threads" && std::atoi(argv[i + 1]) > 0) {
+            db.SetParallelism(std::atoi(argv[i + 1]));
+        } else if (option != "--durability" || !DB::WriteAheadLog::SeeDurability(argv[i + 1], durability)) {
+            std::cout << "-- USAGE: " << argv[0] << " [--port N] [--socket PATH] [--workers N] [--wal PATH]"
+                      << " [--durability fsync|group|buffered] [--threads N] --\n" << std::endl;
+            return 1;
+        }
+    }
+    if (port < 0 && socket.empty())
+        port = 5480;
+    if (!wal.empty()) {
+        std::string message;
+        bool opened = db.Open(wal, durability, message);
+        std::cout << message << std::endl;
+        if (!opened)
+            return 1;
+    }
+    DB::Server server(db);
+    std::string message;
+    bool listening = server.Listen(port, socket, message);
+    std::cout << message << std::endl;
+    if (!listening)
+        return 1;
+    server.Start(workers);
+    int signal;
+    sigwait(&signals, &signal);
+
+    return 0;
+}
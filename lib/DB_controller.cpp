@@ -1,150 +1,469 @@
 #include "DB_controller.h"
+#include "arena.h"
+#include "metrics.h"
+#include "profile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 
 using namespace DB;
 
-void Controller::StripSpaces(std::string& str) {
-    str.erase(remove_if(str.begin(), str.end(), isspace), str.end());
+void Controller::Write(Cursor cursor) {
+    std::string line;
+    while (cursor.Next(line)) {
+        *out_ << line << '\n';
+    }
+    out_->flush();
 }
 
-std::vector<std::pair<std::string, std::string>> Controller::ParsePairsCSV(std::string data) {
-    std::smatch match;
-    std::vector<std::pair<std::string, std::string>> result;
-    while (std::regex_search(data, match, reg_pairs_csv)) {
-        result.emplace_back(match[1], match[2]);
-        data = match[3];
-    }
+bool Controller::in_transaction() const {
+    return transaction_.open();
+}
+
+static bool ParseBound(const std::string& text, size_t& value) {
+    if (text.empty())
+        return true;
+    if (!Column::IsValid(INT, text) || text[0] == '-')
+        return false;
+    value = std::stoull(text);
 
-    return result;
+    return true;
 }
 
-std::vector<std::string> Controller::ParseSeparated(std::string data, const std::regex& separation) {
-    std::smatch match;
-    std::vector<std::string> result;
-    while (std::regex_search(data, match, separation)) {
-        result.emplace_back(match[1]);
-        data = match[2];
+bool Controller::MakeOrdering(const Statement& statement, Ordering& ordering, std::string& message) {
+    ordering.keys = statement.order_by;
+    if (!ParseBound(statement.limit, ordering.limit)) {
+        message = "-- INVALID LIMIT " + statement.limit + " --\n";
+        return false;
     }
-    if (std::regex_search(data, match, reg_single)) {
-        result.emplace_back(match[1]);
+    if (!ParseBound(statement.offset, ordering.offset)) {
+        message = "-- INVALID OFFSET " + statement.offset + " --\n";
+        return false;
     }
 
-    return result;
+    return true;
 }
 
-Condition Controller::MakeSingleCondition(const std::string& condition) {
-    std::smatch match;
-    if (std::regex_search(condition, match, reg_condition))
-        return {match[2], match[1], match[3]};
+static std::string List(const std::vector<std::string>& names) {
+    std::string list;
+    for (auto& name : names) {
+        list += (list.empty() ? "" : ", ") + name;
+    }
+
+    return list;
 }
 
-std::vector<std::vector<Condition>> Controller::GetConditions(const std::string& input) {
-    std::smatch match;
-    auto OR_separated = ParseSeparated(input, reg_or_separate);
-    std::vector<std::vector<Condition>> result(OR_separated.size());
-    std::vector<std::string> AND_separated;
-    for (int i = 0; i < OR_separated.size(); ++i) {
-        result[i] = std::vector<Condition>();
-        AND_separated = ParseSeparated(OR_separated[i], reg_and_separate);
-        for (auto& condition : AND_separated) {
-            result[i].emplace_back(MakeSingleCondition(condition));
+static std::string Describe(const std::vector<std::vector<Condition>>& conditions) {
+    std::string text;
+    for (auto& conjunction : conditions) {
+        std::string terms;
+        for (auto& condition : conjunction) {
+            bool parameter = !condition.rhs().empty() && condition.rhs()[0] == '\0';
+            terms += (terms.empty() ? "" : " AND ") + condition.lhs() + " " + condition.symbol() + " " +
+                     (parameter ? "?" : condition.rhs());
         }
+        text += (text.empty() ? "" : " OR ") + (conditions.size() > 1 ? "(" + terms + ")" : terms);
     }
 
-    return result;
+    return text;
 }
 
-std::vector<std::pair<std::string, std::string>> Controller::GetValuePairs(std::string input) {
-    std::smatch match;
-    std::vector<std::pair<std::string, std::string>> result;
-    StripSpaces(input);
-    auto pairs = ParseSeparated(input, reg_csv);
-    for (auto& elem : pairs) {
-        if (std::regex_search(elem, match, reg_assignment)) {
-            result.emplace_back(match[1], match[2]);
+Cursor Controller::Explain(const Statement& statement) {
+    Plan compiled;
+    const Plan* plan = &compiled;
+    if (statement.type == EXECUTE) {
+        auto found = prepared_.find(statement.name);
+        if (found == prepared_.end())
+            return Cursor("-- NO PREPARED STATEMENT " + statement.name + " FOUND --\n");
+        plan = &found->second;
+    } else {
+        compiled = Parser::Compile(statement);
+    }
+    const Statement& target = plan->statement;
+    std::vector<std::string> lines;
+    int depth = 0;
+    auto add = [&](const std::string& line) { lines.emplace_back(std::string(depth * 2, ' ') + line); };
+    std::string access;
+    if (target.type == SELECT) {
+        add("output " + List(target.columns));
+        ++depth;
+        std::vector<std::string> keys;
+        for (auto& key : target.order_by) {
+            keys.emplace_back(key.column + (key.descending ? " DESC" : ""));
+        }
+        std::string window = (target.limit.empty() ? "" : " LIMIT " + target.limit) +
+                             (target.offset.empty() ? "" : " OFFSET " + target.offset);
+        if (!keys.empty()) {
+            add((target.limit.empty() ? "sort " : "top-n sort ") + List(keys) + window);
+            ++depth;
+        } else if (!window.empty()) {
+            add("limit" + window);
+            ++depth;
         }
+        if (target.has_having) {
+            add("having " + Describe(plan->having));
+            ++depth;
+        }
+        if (target.has_group) {
+            std::vector<std::string> aggregates;
+            for (auto& aggregate : target.aggregates) {
+                if (aggregate.function != AGGREGATE_NONE &&
+                    std::find(aggregates.begin(), aggregates.end(), aggregate.Name()) == aggregates.end())
+                    aggregates.emplace_back(aggregate.Name());
+            }
+            add("hash aggregate " + List(aggregates) +
+                (target.group_by.empty() ? "" : " GROUP BY " + List(target.group_by)));
+            ++depth;
+        }
+        if (target.has_join) {
+            if (target.has_where) {
+                add("filter " + Describe(plan->where) + " on joined rows");
+                ++depth;
+            }
+            if (!database_->ExplainJoin(target.table, target.join.table, plan->on, access))
+                return Cursor("-- NO TABLE " + target.table + " OR " + target.join.table + " FOUND --\n");
+            add(target.join.type + " join " + Describe(plan->on) + ": " + access);
+            ++depth;
+            add("scan " + target.table + " all rows");
+            add("scan " + target.join.table + " all rows");
+        } else if (!target.has_where) {
+            add("scan " + target.table + " all rows");
+        } else {
+            if (!database_->ExplainScan(target.table, plan->where, access))
+                return Cursor("-- NO TABLE " + target.table + " FOUND --\n");
+            add("scan " + access + ", filter " + Describe(plan->where));
+        }
+    } else if (target.type == INSERT) {
+        add("insert " + std::to_string(target.values.size()) + " rows into " + target.table);
+    } else if (target.type == UPDATE || target.type == DELETE) {
+        std::vector<std::string> assignments;
+        for (auto& assignment : target.assignments) {
+            assignments.emplace_back(assignment.first + " = " + assignment.second);
+        }
+        add(target.type == UPDATE ? "update " + target.table + " SET " + List(assignments)
+                                  : "delete from " + target.table);
+        ++depth;
+        if (!database_->ExplainScan(target.table, plan->where, access))
+            return Cursor("-- NO TABLE " + target.table + " FOUND --\n");
+        add("scan " + access + (target.has_where ? ", filter " + Describe(plan->where) : ""));
+    } else {
+        return Cursor("-- CANNOT EXPLAIN THIS STATEMENT --\n");
     }
 
-    return result;
+    Column column(TEXT, 10);
+    for (auto& line : lines) {
+        column.Append(line);
+    }
+    std::map<std::string, Column> columns;
+    columns.emplace("QUERY PLAN", std::move(column));
+
+    return {std::make_shared<Table>(std::move(columns), lines.size()), {"QUERY PLAN"}, Bitmap(lines.size(), true),
+            nullptr};
 }
 
-void Controller::ReadInput(const std::string& input) {
-    std::smatch match;
-    if (std::regex_search(input, match, reg_create)) {
-        std::string name = match[1];
-        StripSpaces(name);
-        std::string parameters = match[2];
-        std::vector<std::pair<std::string, std::string>> columns = ParsePairsCSV(parameters);
-        database_->CreateTable(name, columns);
-        std::cout << std::endl << "-- TABLE " << name << " CREATED --\n" << std::endl;
-    } else if (std::regex_search(input, match, reg_drop)) {
-        std::string name = match[1];
-        StripSpaces(name);
-        database_->DeleteTable(name);
-        std::cout << std::endl << "-- TABLE " << name << " DELETED --\n" << std::endl;
-    } else if (std::regex_search(input, match, reg_select_where_join)) {
-        std::vector<std::string> columns = ParseSeparated(match[1], reg_csv);
-        std::string table_l = match[2];
-        StripSpaces(table_l);
-        std::string type = match[3];
-        std::string table_r = match[4];
-        StripSpaces(table_r);
-        auto join_on = GetConditions(match[5]);
-        auto conditions = GetConditions(match[6]);
-        auto output = database_->SelectJoined(table_l, table_r, type, join_on, columns, conditions);
-        for (auto& row : output) {
-            std::cout << row << std::endl;
-        }
-    } else if (std::regex_search(input, match, reg_select_join)) {
-        std::vector<std::string> columns = ParseSeparated(match[1], reg_csv);
-        std::string table_l = match[2];
-        StripSpaces(table_l);
-        std::string type = match[3];
-        std::string table_r = match[4];
-        StripSpaces(table_r);
-        auto join_on = GetConditions(match[5]);
-        auto output = database_->SelectAllJoined(table_l, table_r, type, join_on, columns);
-        for (auto& row : output) {
-            std::cout << row << std::endl;
+Cursor Controller::Analyze(std::string text) {
+    Profile profile;
+    size_t allocated = Profile::Allocated();
+    auto start = std::chrono::steady_clock::now();
+    size_t lines = 0;
+    std::string first;
+    {
+        Cursor result = Query(text);
+        PROFILE_SCOPE(stage, "output");
+        std::string line;
+        while (result.Next(line)) {
+            if (lines++ == 0)
+                first = line;
         }
-    } else if (std::regex_search(input, match, reg_select_where)) {
-        std::vector<std::string> columns = ParseSeparated(match[1], reg_csv);
-        std::string table = match[2];
-        StripSpaces(table);
-        auto conditions = GetConditions(match[3]);
-        auto output = database_->Select(table, columns, conditions);
-        for (auto& row : output) {
-            std::cout << row << std::endl;
+        PROFILE(stage.Rows(lines, lines));
+    }
+    if (lines == 1 && first.compare(0, 3, "-- ") == 0)
+        return Cursor(first);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<ProfileStage> stages = profile.stages();
+    ProfileStage& total = stages.emplace_back();
+    total.name = "total";
+    total.seconds = seconds;
+    total.rows_out = lines;
+    total.bytes = Profile::Allocated() - allocated;
+    static const char* kNames[] = {"stage", "ms", "rows in", "rows out", "evaluations", "bytes"};
+    std::map<std::string, Column> columns;
+    columns.emplace(kNames[0], Column(TEXT, 5));
+    columns.emplace(kNames[1], Column(DOUBLE, 2));
+    for (size_t i = 2; i < 6; ++i) {
+        columns.emplace(kNames[i], Column(INT, std::string(kNames[i]).size()));
+    }
+    for (auto& stage : stages) {
+        columns[kNames[0]].Append(std::string(stage.depth * 2, ' ') + stage.name +
+                                  (stage.detail.empty() ? "" : " " + stage.detail));
+        columns[kNames[1]].Append(std::to_string(std::round(stage.seconds * 1e6) / 1e3));
+        size_t values[] = {stage.rows_in, stage.rows_out, stage.evaluations, stage.bytes};
+        for (size_t i = 0; i < 4; ++i) {
+            columns[kNames[i + 2]].Append(std::to_string(values[i]));
         }
-    } else if (std::regex_search(input, match, reg_select)) {
-        std::vector<std::string> columns = ParseSeparated(match[1], reg_csv);
-        std::string table = match[2];
-        StripSpaces(table);
-        auto output = database_->SelectAll(table, columns);
-        for (auto& row : output) {
-            std::cout << row << std::endl;
+    }
+
+    return {std::make_shared<Table>(std::move(columns), stages.size()),
+            std::vector<std::string>(std::begin(kNames), std::end(kNames)), Bitmap(stages.size(), true), nullptr};
+}
+
+Cursor Controller::ShowStats(const std::string& path) {
+    std::vector<MetricSample> samples = database_->Stats();
+    if (!path.empty()) {
+        std::ofstream file(path, std::ios::trunc);
+        file << Metrics::ToPrometheus(samples);
+        if (!file.flush())
+            return Cursor("-- CANNOT WRITE FILE " + path + " --\n");
+        return Cursor("\n-- STATS WRITTEN TO " + path + " --\n");
+    }
+    std::map<std::string, Column> columns;
+    columns.emplace("metric", Column(TEXT, 6));
+    columns.emplace("value", Column(TEXT, 5));
+    for (auto& sample : samples) {
+        columns["metric"].Append(sample.name + (sample.labels.empty() ? "" : "{" + sample.labels + "}"));
+        columns["value"].Append(Metrics::Format(sample.value));
+    }
+
+    return {std::make_shared<Table>(std::move(columns), samples.size()), {"metric", "value"},
+            Bitmap(samples.size(), true), nullptr};
+}
+
+Plan* Controller::Compile(std::string_view input, std::vector<std::string>& parameters, std::string& error) {
+    PROFILE_SCOPE(stage, "parse");
+    auto start = std::chrono::steady_clock::now();
+    parameters.clear();
+    std::string key = Parser::Normalize(input, parameters);
+    if (!key.empty()) {
+        auto found = cache_.find(key);
+        PROFILE(stage.Detail(found != cache_.end() ? "plan cache hit" : "plan cache miss"));
+        if (found != cache_.end())
+            return &found->second;
+        Statement statement;
+        Parser parser(key);
+        if (parser.Parse(statement) && statement.parameters == parameters.size()) {
+            if (cache_.size() >= kCacheSize)
+                cache_.clear();
+            return &cache_.emplace(std::move(key), Parser::Compile(std::move(statement))).first->second;
         }
-    } else if (std::regex_search(input, match, reg_insert)) {
-        std::string name = match[1];
-        StripSpaces(name);
-        std::vector<std::string> columns;
-        if (match[2] == "")
-            columns = {""};
-        else
-            columns = ParseSeparated(match[2].str().substr(1, match[2].str().size() - 2), reg_csv);
-        std::vector<std::string> values = ParseSeparated(match[3], reg_csv);
-        database_->Insert(name, columns, values);
-    } else if (std::regex_search(input, match, reg_delete)) {
-        std::string name = match[1];
-        StripSpaces(name);
-        auto conditions = GetConditions(match[2]);
-        database_->Delete(name, conditions);
-    } else if (std::regex_search(input, match, reg_update)) {
-        std::string name = match[1];
-        StripSpaces(name);
-        auto values = GetValuePairs(match[2]);
-        auto conditions = GetConditions(match[3]);
-        database_-> Update(name, values, conditions);
-    } else {
-        std::cout << "-- INVALID COMMAND --\n" << std::endl;
+        parameters.clear();
+    }
+    Statement statement;
+    Parser parser(input);
+    if (!parser.Parse(statement)) {
+        database_->metrics().Record(STATEMENT_ERROR, std::chrono::steady_clock::now() - start);
+        error = parser.error();
+        return nullptr;
+    }
+    scratch_ = Parser::Compile(std::move(statement));
+
+    return &scratch_;
+}
+
+bool Controller::Writes(const Plan& plan) const {
+    const Statement* statement = &plan.statement;
+    if (statement->type == EXPLAIN) {
+        if (!statement->analyze)
+            return false;
+        statement = statement->prepared.get();
+    }
+    StatementType type = statement->type;
+    if (type == EXECUTE) {
+        auto found = prepared_.find(statement->name);
+        if (found == prepared_.end())
+            return false;
+        type = found->second.statement.type;
     }
+
+    return type != SELECT && type != BEGIN && type != COMMIT && type != ROLLBACK && type != PREPARE &&
+           type != DEALLOCATE && type != SHOW_STATS;
+}
+
+static StatementKind Kind(StatementType type) {
+    switch (type) {
+        case SELECT:
+            return STATEMENT_SELECT;
+        case INSERT:
+            return STATEMENT_INSERT;
+        case UPDATE:
+            return STATEMENT_UPDATE;
+        case DELETE:
+            return STATEMENT_DELETE;
+        case CREATE_TABLE:
+        case DROP_TABLE:
+        case CREATE_INDEX:
+        case DROP_INDEX:
+            return STATEMENT_DDL;
+        case COPY:
+            return STATEMENT_COPY;
+        case BEGIN:
+        case COMMIT:
+        case ROLLBACK:
+            return STATEMENT_TRANSACTION;
+        default:
+            return STATEMENT_OTHER;
+    }
+}
+
+Cursor Controller::Run(Plan& plan, const std::vector<std::string>& parameters) {
+    auto start = std::chrono::steady_clock::now();
+    StatementType type = plan.statement.type;
+    if (type == EXECUTE) {
+        auto found = prepared_.find(plan.statement.name);
+        if (found != prepared_.end())
+            type = found->second.statement.type;
+    }
+    Cursor cursor;
+    {
+        ArenaScope arena;
+        cursor = Dispatch(plan, parameters);
+    }
+    database_->metrics().Record(cursor.failed() ? STATEMENT_ERROR : Kind(type),
+                                std::chrono::steady_clock::now() - start);
+
+    return cursor;
+}
+
+Cursor Controller::Dispatch(Plan& plan, const std::vector<std::string>& parameters) {
+    if (!Parser::Bind(plan, parameters))
+        return Cursor("-- EXPECTED " + std::to_string(plan.statement.parameters) + " PARAMETERS, GOT " +
+                      std::to_string(parameters.size()) + " --\n");
+    const Statement& statement = plan.statement;
+    bool transactional = statement.type == SELECT || statement.type == INSERT || statement.type == DELETE ||
+                         statement.type == UPDATE || statement.type == COPY || statement.type == BEGIN ||
+                         statement.type == COMMIT || statement.type == ROLLBACK || statement.type == PREPARE ||
+                         statement.type == EXECUTE || statement.type == DEALLOCATE || statement.type == EXPLAIN ||
+                         statement.type == SHOW_STATS;
+    if (transaction_.open() && !transactional)
+        return Cursor("-- CANNOT RUN THIS STATEMENT INSIDE A TRANSACTION --\n");
+    if (statement.type == PREPARE) {
+        if (prepared_.count(statement.name) != 0)
+            return Cursor("-- PREPARED STATEMENT " + statement.name + " ALREADY EXISTS --\n");
+        prepared_.emplace(statement.name, Parser::Compile(*statement.prepared));
+        return Cursor("\n-- STATEMENT " + statement.name + " PREPARED --\n");
+    }
+    if (statement.type == EXECUTE) {
+        auto found = prepared_.find(statement.name);
+        if (found == prepared_.end())
+            return Cursor("-- NO PREPARED STATEMENT " + statement.name + " FOUND --\n");
+        return Dispatch(found->second, statement.values[0]);
+    }
+    if (statement.type == DEALLOCATE) {
+        if (prepared_.erase(statement.name) == 0)
+            return Cursor("-- NO PREPARED STATEMENT " + statement.name + " FOUND --\n");
+        return Cursor("\n-- STATEMENT " + statement.name + " DEALLOCATED --\n");
+    }
+    if (statement.type == EXPLAIN)
+        return statement.analyze ? Analyze(statement.text) : Explain(*statement.prepared);
+    if (statement.type == SHOW_STATS)
+        return ShowStats(statement.path);
+    if (statement.type == CREATE_TABLE)
+        return Cursor(database_->CreateTable(statement.table, statement.definitions, statement.primary_key));
+    if (statement.type == DROP_TABLE)
+        return Cursor(database_->DeleteTable(statement.table));
+    if (statement.type == CREATE_INDEX)
+        return Cursor(database_->CreateIndex(statement.index, statement.table, statement.columns[0]));
+    if (statement.type == DROP_INDEX)
+        return Cursor(database_->DropIndex(statement.index));
+    if (statement.type == SELECT) {
+        Ordering ordering;
+        std::string message;
+        if (!MakeOrdering(statement, ordering, message))
+            return Cursor(message);
+        if (statement.has_group && statement.has_join)
+            return database_->SelectGroupedJoined(statement.table, statement.join.table, statement.join.type, plan.on,
+                                                  statement.aggregates, statement.group_by, statement.columns,
+                                                  plan.where, plan.having, ordering, &transaction_);
+        if (statement.has_group)
+            return database_->SelectGrouped(statement.table, statement.aggregates, statement.group_by,
+                                            statement.columns, plan.where, plan.having, ordering, &transaction_);
+        if (statement.has_join && statement.has_where)
+            return database_->SelectJoined(statement.table, statement.join.table, statement.join.type,
+                                           plan.on, statement.columns,
+                                           plan.where, ordering, &transaction_);
+        if (statement.has_join)
+            return database_->SelectAllJoined(statement.table, statement.join.table, statement.join.type,
+                                              plan.on, statement.columns, ordering, &transaction_);
+        if (statement.has_where)
+            return database_->Select(statement.table, statement.columns, plan.where, ordering, &transaction_);
+        return database_->SelectAll(statement.table, statement.columns, ordering, &transaction_);
+    }
+    if (statement.type == INSERT) {
+        if (statement.columns.empty())
+            return Cursor(database_->Insert(statement.table, {""}, statement.values, &transaction_));
+        return Cursor(database_->Insert(statement.table, statement.columns, statement.values, &transaction_));
+    }
+    if (statement.type == DELETE)
+        return Cursor(database_->Delete(statement.table, plan.where, &transaction_));
+    if (statement.type == UPDATE)
+        return Cursor(database_->Update(statement.table, statement.assignments, plan.where,
+                                        &transaction_));
+    if (statement.type == VACUUM)
+        return Cursor(database_->Vacuum(statement.table));
+    if (statement.type == COPY)
+        return Cursor(database_->Copy(statement.table, statement.columns, statement.path, statement.delimiter,
+                                      statement.header, &transaction_));
+    if (statement.type == CHECKPOINT)
+        return Cursor(database_->Checkpoint());
+    if (statement.type == BEGIN)
+        return Cursor(database_->Begin(transaction_));
+    if (statement.type == COMMIT)
+        return Cursor(database_->Commit(transaction_));
+
+    return Cursor(database_->Rollback(transaction_));
+}
+
+Cursor Controller::Run(const Statement& statement) {
+    scratch_ = Parser::Compile(statement);
+
+    return Run(scratch_, {});
+}
+
+Cursor Controller::Query(std::string_view input) {
+    std::string error;
+    Plan* plan = Compile(input, parameters_, error);
+    if (plan == nullptr)
+        return Cursor(error);
+
+    return Run(*plan, parameters_);
+}
+
+Cursor Controller::Prepare(const std::string& name, const std::string& text) {
+    Plan prepare;
+    prepare.statement.type = PREPARE;
+    prepare.statement.name = name;
+    prepare.statement.prepared = std::make_shared<Statement>();
+    Parser parser(text);
+    if (!parser.Parse(*prepare.statement.prepared))
+        return Cursor(parser.error());
+    StatementType type = prepare.statement.prepared->type;
+    if (type == PREPARE || type == EXECUTE || type == DEALLOCATE)
+        return Cursor("-- CANNOT PREPARE THIS STATEMENT --\n");
+
+    return Run(prepare, {});
+}
+
+Cursor Controller::ExecutePrepared(const std::string& name, const std::vector<std::string>& parameters) {
+    auto found = prepared_.find(name);
+    if (found == prepared_.end())
+        return Cursor("-- NO PREPARED STATEMENT " + name + " FOUND --\n");
+
+    return Run(found->second, parameters);
+}
+
+Cursor Controller::Deallocate(const std::string& name) {
+    if (prepared_.erase(name) == 0)
+        return Cursor("-- NO PREPARED STATEMENT " + name + " FOUND --\n");
+
+    return Cursor("\n-- STATEMENT " + name + " DEALLOCATED --\n");
+}
+
+void Controller::Execute(const Statement& statement) {
+    Write(Run(statement));
+}
+
+void Controller::ReadInput(const std::string& input) {
+    Write(Query(input));
 }
@@ -1,55 +1,74 @@
 #pragma once
 
 #include "database.h"
+#include "parser.h"
+
+#include <unordered_map>
 
 namespace DB {
 
     class Controller {
     private:
         MyAwesomeDB *database_;
+        std::ostream *out_;
+        Transaction transaction_;
+        std::unordered_map<std::string, Plan> prepared_;
+        std::unordered_map<std::string, Plan> cache_;
+        Plan scratch_;
+        std::vector<std::string> parameters_;
+
+        static constexpr size_t kCacheSize = 1024;
+
+        void Write(Cursor cursor);
+
+        static bool MakeOrdering(const Statement &statement, Ordering &ordering, std::string &message);
+
+        Cursor Explain(const Statement &statement);
+
+        // Runs text and reports its stages instead of its result.
+        Cursor Analyze(std::string text);
 
-        std::regex reg_create = std::regex(R"(^\s*CREATE TABLE\s+([\w_]+)\s+\(([\S\s]+,)\s*PRIMARY\s*KEY\(.+\)\)\s*;)");
-        std::regex reg_pairs_csv = std::regex(R"(^\s*([\w_]+)\s+([\w_]+)\s*,\s*([\S\s]*))");
-        std::regex reg_csv = std::regex(R"(^\s*([\w_=\.]+)\s*,\s*(.*))");
-        std::regex reg_single = std::regex(R"(^\s*([\w*_\s><=\"\.]+))");
-        std::regex reg_drop = std::regex(R"(^\s*DROP TABLE\s+([\w_]+);)");
-        std::regex reg_select_where_join = std::regex(
-                R"(^\s*SELECT\s+([\w*,_\s\.]+)FROM\s+([\w_]+)\s+(INNER|LEFT|RIGHT)\s+JOIN\s+([\w_]+)\s+ON\s+([\S\s]+)WHERE\s+([\S\s]+);)");
-        std::regex reg_select_join = std::regex(
-                R"(^\s*SELECT\s+([\w*,_\s\.]+)FROM\s+([\w_]+)\s+(INNER|LEFT|RIGHT)\s+JOIN\s+([\w_]+)\s+ON\s+([\S\s]+);)");
-        std::regex reg_select_where = std::regex(R"(^\s*SELECT\s+([\w*,_\s\.]+)FROM\s+([\w,_\s]+)WHERE\s+([\S\s]+);)");
-        std::regex reg_select = std::regex(R"(^\s*SELECT\s+([\w*,_\s\.]+)FROM\s+([\w,_\s]+);)");
-        std::regex reg_insert = std::regex(
-                R"(^\s*INSERT INTO\s+([\w_]+)\s+(\([\w_,\s]+\))?\s*VALUES\s+\(([\w_\.,\s]+)\)\s*;)");
-        std::regex reg_or_separate = std::regex(R"(^\s*([\w_\s><=!\"\.]+)OR\s+([\w_\s><=!\"\.]+))");
-        std::regex reg_and_separate = std::regex(R"(^\s*([\w_\s><=!\"\.]+)AND\s+([\w_\s><=!\"\.]+))");
-        std::regex reg_condition = std::regex(R"(^\s*([\w_\.]+)\s*([><=!]+)\s*([\w_\"\.]+)\s*)");
-        std::regex reg_delete = std::regex(R"(^\s*DELETE FROM\s+([\w_]+)\s+WHERE\s+([\S\s]+);)");
-        std::regex reg_update = std::regex(R"(^\s*UPDATE\s+([\w_]+)\s+SET(.+)\s+WHERE\s+([\S\s]+);)");
-        std::regex reg_assignment = std::regex(R"(^\s*([\w_]+)\s*=\s*([\w_]+)\s*)");
-
-        static void StripSpaces(std::string &str);
+        // Lists the metrics, or writes them to path in the Prometheus text format.
+        Cursor ShowStats(const std::string &path);
+
+        Cursor Dispatch(Plan &plan, const std::vector<std::string> &parameters);
 
     public:
         Controller()
-                : database_(nullptr) {}
+                : database_(nullptr)
+                , out_(&std::cout) {}
 
-        explicit Controller(MyAwesomeDB &database)
-                : database_(&database) {}
+        explicit Controller(MyAwesomeDB &database, std::ostream &out = std::cout)
+                : database_(&database)
+                , out_(&out) {}
 
         ~Controller() {
+            if (database_ != nullptr)
+                database_->Rollback(transaction_);
             database_ = nullptr;
         }
 
-        std::vector <std::pair<std::string, std::string>> ParsePairsCSV(std::string data);
+        bool in_transaction() const;
+
+        // Returns the cached plan for the input with its literals moved into parameters, or
+        // nullptr with the syntax error in error.
+        Plan *Compile(std::string_view input, std::vector<std::string> &parameters, std::string &error);
+
+        bool Writes(const Plan &plan) const;
+
+        Cursor Run(Plan &plan, const std::vector<std::string> &parameters);
+
+        Cursor Run(const Statement &statement);
+
+        Cursor Query(std::string_view input);
 
-        std::vector <std::string> ParseSeparated(std::string data, const std::regex &separation);
+        Cursor Prepare(const std::string &name, const std::string &text);
 
-        Condition MakeSingleCondition(const std::string &condition);
+        Cursor ExecutePrepared(const std::string &name, const std::vector<std::string> &parameters);
 
-        std::vector <std::vector<Condition>> GetConditions(const std::string& input);
+        Cursor Deallocate(const std::string &name);
 
-        std::vector <std::pair<std::string, std::string>> GetValuePairs(std::string input);
+        void Execute(const Statement &statement);
 
         void ReadInput(const std::string &input);
     };
@@ -0,0 +1,279 @@
+#include "aggregate.h"
+#include "thread_pool.h"
+
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <numeric>
+
+using namespace DB;
+
+static std::string Unqualified(const std::string& name) {
+    size_t dot = name.find('.');
+
+    return dot == std::string::npos ? name : name.substr(dot + 1);
+}
+
+static uint64_t Mix(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+static std::string Format(double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+
+    return std::string(buffer, result.ptr);
+}
+
+Aggregator::Source::Source(const Column* column)
+        : column(column)
+{
+    if (column == nullptr)
+        return;
+    type = column->type();
+    nulls = column->nulls().words();
+    ints = column->ints();
+    doubles = column->doubles();
+}
+
+int Aggregator::Source::Compare(size_t lhs, size_t rhs) const {
+    if (type == INT)
+        return (ints[lhs] > ints[rhs]) - (ints[lhs] < ints[rhs]);
+    if (type == DOUBLE)
+        return (doubles[lhs] > doubles[rhs]) - (doubles[lhs] < doubles[rhs]);
+    if (type == BOOL)
+        return int(column->GetBool(lhs)) - int(column->GetBool(rhs));
+
+    return column->GetText(lhs).compare(column->GetText(rhs));
+}
+
+bool Aggregator::Resolve(Table* table, std::string& message) {
+    for (auto& name : group_by_) {
+        std::string column = Unqualified(name);
+        if (!table->IsColumnName(column)) {
+            message = "-- NO COLUMN " + name + " FOUND --\n";
+            return false;
+        }
+        if (std::find(key_names_.begin(), key_names_.end(), column) != key_names_.end())
+            continue;
+        key_names_.emplace_back(column);
+        keys_.emplace_back(&table->GetColumn(column));
+    }
+    for (auto& aggregate : aggregates_) {
+        if (aggregate.function == AGGREGATE_NONE) {
+            if (std::find(key_names_.begin(), key_names_.end(), Unqualified(aggregate.column)) == key_names_.end()) {
+                message = "-- COLUMN " + aggregate.column + " MUST APPEAR IN GROUP BY --\n";
+                return false;
+            }
+            continue;
+        }
+        std::string name = aggregate.Name();
+        if (std::find(names_.begin(), names_.end(), name) != names_.end())
+            continue;
+        const Column* input = nullptr;
+        if (aggregate.column != "*") {
+            std::string column = Unqualified(aggregate.column);
+            if (!table->IsColumnName(column)) {
+                message = "-- NO COLUMN " + aggregate.column + " FOUND --\n";
+                return false;
+            }
+            input = &table->GetColumn(column);
+        }
+        if ((aggregate.function == AGGREGATE_SUM || aggregate.function == AGGREGATE_AVG) &&
+            (input == nullptr || (input->type() != INT && input->type() != DOUBLE))) {
+            message = "-- COLUMN " + aggregate.column + " IS NOT NUMERIC --\n";
+            return false;
+        }
+        names_.emplace_back(name);
+        functions_.emplace_back(aggregate.function);
+        inputs_.emplace_back(input);
+    }
+
+    return true;
+}
+
+uint64_t Aggregator::Hash(size_t row) const {
+    uint64_t hash = 0x9e3779b97f4a7c15ULL;
+    for (auto& key : keys_) {
+        uint64_t value = 0x5bd1e9955bd1e995ULL;
+        if (key.IsNull(row)) {
+        } else if (key.type == INT) {
+            value = key.ints[row];
+        } else if (key.type == DOUBLE) {
+            double number = key.doubles[row] == 0 ? 0.0 : key.doubles[row];
+            std::memcpy(&value, &number, sizeof(value));
+        } else if (key.type == BOOL) {
+            value = key.column->GetBool(row);
+        } else {
+            value = std::hash<std::string_view>()(key.column->GetText(row));
+        }
+        hash = Mix(hash ^ value);
+    }
+
+    return hash;
+}
+
+bool Aggregator::Equal(size_t lhs, size_t rhs) const {
+    for (auto& key : keys_) {
+        bool null = key.IsNull(lhs);
+        if (null != key.IsNull(rhs))
+            return false;
+        if (!null && key.Compare(lhs, rhs) != 0)
+            return false;
+    }
+
+    return true;
+}
+
+void Aggregator::Grow(Groups& groups) {
+    groups.slots.assign(std::max(kMinSlots, groups.slots.size() * 2), 0);
+    size_t mask = groups.slots.size() - 1;
+    for (size_t group = 0; group < groups.hashes.size(); ++group) {
+        size_t slot = groups.hashes[group] & mask;
+        while (groups.slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        groups.slots[slot] = group + 1;
+    }
+}
+
+size_t Aggregator::Find(Groups& groups, uint64_t hash, size_t row) const {
+    if ((groups.rows.size() + 1) * 2 > groups.slots.size())
+        Grow(groups);
+    size_t mask = groups.slots.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        uint32_t group = groups.slots[slot];
+        if (group == 0) {
+            groups.slots[slot] = groups.rows.size() + 1;
+            groups.hashes.emplace_back(hash);
+            groups.rows.emplace_back(row);
+            groups.values.resize(groups.values.size() + functions_.size());
+            return groups.rows.size() - 1;
+        }
+        if (groups.hashes[group - 1] == hash && Equal(groups.rows[group - 1], row))
+            return group - 1;
+    }
+}
+
+bool Aggregator::Better(Aggregates function, const Source& input, size_t candidate, size_t best) {
+    int order = input.Compare(candidate, best);
+
+    return function == AGGREGATE_MIN ? order < 0 : order > 0;
+}
+
+void Aggregator::Accumulate(Accumulator* values, size_t row) const {
+    for (size_t i = 0; i < functions_.size(); ++i) {
+        const Source& input = inputs_[i];
+        Accumulator& value = values[i];
+        if (input.IsNull(row))
+            continue;
+        ++value.count;
+        if (functions_[i] == AGGREGATE_SUM || functions_[i] == AGGREGATE_AVG) {
+            if (input.type == INT)
+                value.int_sum += input.ints[row];
+            else
+                value.double_sum += input.doubles[row];
+        } else if (functions_[i] == AGGREGATE_MIN || functions_[i] == AGGREGATE_MAX) {
+            if (value.best == SIZE_MAX || Better(functions_[i], input, row, value.best))
+                value.best = row;
+        }
+    }
+}
+
+void Aggregator::Merge(Accumulator* values, const Accumulator* other) const {
+    for (size_t i = 0; i < functions_.size(); ++i) {
+        values[i].count += other[i].count;
+        values[i].int_sum += other[i].int_sum;
+        values[i].double_sum += other[i].double_sum;
+        size_t candidate = other[i].best;
+        if (candidate == SIZE_MAX)
+            continue;
+        size_t& best = values[i].best;
+        if (best == SIZE_MAX || Better(functions_[i], inputs_[i], candidate, best) ||
+            (candidate < best && !Better(functions_[i], inputs_[i], best, candidate)))
+            best = candidate;
+    }
+}
+
+Table* Aggregator::Run(const Bitmap& selected, ThreadPool& pool, std::string& message) const {
+    size_t morsels = (selected.Size() + kMorselRows - 1) / kMorselRows;
+    std::vector<Groups> partials(std::max<size_t>(1, std::min(pool.size(), morsels)));
+    std::atomic<size_t> next(0);
+    pool.ParallelFor(partials.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t part = begin; part < end; ++part) {
+            Groups& groups = partials[part];
+            for (size_t morsel = next++; morsel < morsels; morsel = next++) {
+                size_t last = std::min(selected.Size(), (morsel + 1) * kMorselRows);
+                for (size_t row = selected.Next(morsel * kMorselRows); row < last; row = selected.Next(row + 1)) {
+                    // Find grows values, so take its data() only afterwards; values stays empty for GROUP BY without
+                    // aggregates, where indexing into it would be out of range.
+                    size_t group = Find(groups, Hash(row), row);
+                    Accumulate(groups.values.data() + group * functions_.size(), row);
+                }
+            }
+        }
+    });
+    Groups& result = partials[0];
+    for (size_t part = 1; part < partials.size(); ++part) {
+        const Groups& groups = partials[part];
+        for (size_t group = 0; group < groups.rows.size(); ++group) {
+            size_t into = Find(result, groups.hashes[group], groups.rows[group]);
+            result.rows[into] = std::min(result.rows[into], groups.rows[group]);
+            Merge(result.values.data() + into * functions_.size(), groups.values.data() + group * functions_.size());
+        }
+    }
+    if (keys_.empty() && result.rows.empty()) {
+        result.rows.emplace_back(0);
+        result.values.resize(functions_.size());
+    }
+    std::vector<size_t> order(result.rows.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) { return result.rows[lhs] < result.rows[rhs]; });
+
+    std::map<std::string, Column> columns;
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        const Column& key = *keys_[i].column;
+        Column& column = columns[key_names_[i]] = Column(key.type(), key.width());
+        column.Reserve(order.size());
+        for (auto group : order) {
+            column.AppendFrom(key, result.rows[group]);
+        }
+    }
+    for (size_t i = 0; i < functions_.size(); ++i) {
+        Aggregates function = functions_[i];
+        const Column* input = inputs_[i].column;
+        Types type = function == AGGREGATE_COUNT ? INT : function == AGGREGATE_AVG ? DOUBLE : input->type();
+        int width = function == AGGREGATE_MIN || function == AGGREGATE_MAX ? input->width() : 0;
+        Column& column = columns[names_[i]] = Column(type, std::max<int>(width, names_[i].size()));
+        column.Reserve(order.size());
+        for (auto group : order) {
+            const Accumulator& value = result.values[group * functions_.size() + i];
+            if (function == AGGREGATE_COUNT) {
+                column.Append(std::to_string(value.count));
+            } else if (value.count == 0) {
+                column.AppendNull();
+            } else if (function == AGGREGATE_SUM && type == INT) {
+                if (value.int_sum < INT64_MIN || value.int_sum > INT64_MAX) {
+                    message = "-- INTEGER OVERFLOW IN " + names_[i] + " --\n";
+                    return nullptr;
+                }
+                column.Append(std::to_string(static_cast<int64_t>(value.int_sum)));
+            } else if (function == AGGREGATE_SUM) {
+                column.Append(Format(value.double_sum));
+            } else if (function == AGGREGATE_AVG) {
+                double sum = input->type() == INT ? static_cast<double>(value.int_sum) : value.double_sum;
+                column.Append(Format(sum / value.count));
+            } else {
+                column.AppendFrom(*input, value.best);
+            }
+        }
+    }
+
+    return new Table(std::move(columns), order.size());
+}
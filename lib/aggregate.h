@@ -0,0 +1,81 @@
+#pragma once
+
+#include "database.h"
+
+namespace DB {
+
+    // Hash aggregation over the selected rows of one table. Every pool thread fills its own open-addressing table
+    // from the morsels it claims, and the partial tables are merged at the end; groups come out in the order of
+    // their first row.
+    class Aggregator {
+    private:
+        // Raw column data, valid while the table latch is held.
+        struct Source {
+            const Column* column = nullptr;
+            Types type = UNKNOWN;
+            const uint64_t* nulls = nullptr;
+            const int64_t* ints = nullptr;
+            const double* doubles = nullptr;
+
+            explicit Source(const Column* column = nullptr);
+
+            bool IsNull(size_t row) const {
+                return nulls != nullptr && (nulls[row / 64] >> (row % 64) & 1) != 0;
+            }
+
+            int Compare(size_t lhs, size_t rhs) const;
+        };
+
+        // INT sums are kept wide, so no number of int64 rows can overflow them; only the final SUM must fit.
+        struct Accumulator {
+            int64_t count = 0;
+            __int128 int_sum = 0;
+            double double_sum = 0;
+            size_t best = SIZE_MAX;
+        };
+
+        struct Groups {
+            std::vector<uint32_t> slots;
+            std::vector<uint64_t> hashes;
+            std::vector<size_t> rows;
+            std::vector<Accumulator> values;
+        };
+
+        static constexpr size_t kMinSlots = 64;
+
+        std::vector<std::string> group_by_;
+        std::vector<Aggregate> aggregates_;
+        std::vector<std::string> key_names_;
+        std::vector<Source> keys_;
+        std::vector<std::string> names_;
+        std::vector<Aggregates> functions_;
+        std::vector<Source> inputs_;
+
+        uint64_t Hash(size_t row) const;
+
+        bool Equal(size_t lhs, size_t rhs) const;
+
+        static void Grow(Groups& groups);
+
+        size_t Find(Groups& groups, uint64_t hash, size_t row) const;
+
+        void Accumulate(Accumulator* values, size_t row) const;
+
+        void Merge(Accumulator* values, const Accumulator* other) const;
+
+        static bool Better(Aggregates function, const Source& input, size_t candidate, size_t best);
+
+    public:
+        Aggregator(const std::vector<std::string>& group_by, const std::vector<Aggregate>& aggregates)
+                : group_by_(group_by)
+                , aggregates_(aggregates)
+        {}
+
+        bool Resolve(Table* table, std::string& message);
+
+        // One row per group, with a column per group key and per distinct aggregate named by Aggregate::Name; null
+        // with message set when an INT SUM does not fit in 64 bits.
+        Table* Run(const Bitmap& selected, ThreadPool& pool, std::string& message) const;
+    };
+
+}
@@ -0,0 +1,74 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace DB;
+
+Arena& Arena::Local() {
+    static thread_local Arena arena;
+
+    return arena;
+}
+
+void* Arena::Allocate(size_t bytes, size_t alignment) {
+    if (block_ < blocks_.size()) {
+        size_t offset = (used_ + alignment - 1) & ~(alignment - 1);
+        if (offset + bytes <= blocks_[block_].size) {
+            used_ = offset + bytes;
+            return blocks_[block_].data.get() + offset;
+        }
+        ++block_;
+    }
+    // Blocks from block_ on hold nothing, so one too small for the request is replaced.
+    if (block_ == blocks_.size() || blocks_[block_].size < bytes) {
+        size_t size = std::max({kBlockSize, bytes, block_ == 0 ? 0 : std::min(blocks_[block_ - 1].size * 2,
+                                                                               kRetainedSize)});
+        Block block{std::make_unique<char[]>(size), size};
+        if (block_ == blocks_.size())
+            blocks_.emplace_back(std::move(block));
+        else
+            blocks_[block_] = std::move(block);
+    }
+    used_ = bytes;
+
+    return blocks_[block_].data.get();
+}
+
+std::string_view Arena::Copy(std::string_view text) {
+    char* data = Allocate<char>(text.size());
+    std::memcpy(data, text.data(), text.size());
+
+    return {data, text.size()};
+}
+
+size_t Arena::capacity() const {
+    size_t capacity = 0;
+    for (auto& block : blocks_) {
+        capacity += block.size;
+    }
+
+    return capacity;
+}
+
+void Arena::Trim() {
+    size_t kept = 0;
+    size_t retained = 0;
+    while (kept < blocks_.size() && (kept == 0 || retained + blocks_[kept].size <= kRetainedSize)) {
+        retained += blocks_[kept++].size;
+    }
+    blocks_.resize(kept);
+}
+
+ArenaScope::ArenaScope()
+        : arena_(Arena::Local())
+        , block_(arena_.block_)
+        , used_(arena_.used_)
+{}
+
+ArenaScope::~ArenaScope() {
+    arena_.block_ = block_;
+    arena_.used_ = used_;
+    if (block_ == 0 && used_ == 0)
+        arena_.Trim();
+}
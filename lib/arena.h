@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace DB {
+
+    // A bump allocator for temporaries that die with the statement or morsel that made them. Every thread owns one;
+    // ArenaScope rewinds it and freeing is a no-op. Blocks stay for the next statement, so a warm query barely
+    // reaches malloc. Memory taken from the arena must only be grown by the thread that owns it.
+    class Arena {
+    private:
+        struct Block {
+            std::unique_ptr<char[]> data;
+            size_t size;
+        };
+
+        std::vector<Block> blocks_;
+        size_t block_ = 0;
+        size_t used_ = 0;
+
+        static constexpr size_t kBlockSize = 64 * 1024;
+        static constexpr size_t kRetainedSize = 8 * 1024 * 1024;
+
+        friend class ArenaScope;
+
+        // Frees the blocks past the first kRetainedSize bytes; only while nothing is allocated.
+        void Trim();
+
+    public:
+        Arena() = default;
+
+        Arena(const Arena&) = delete;
+
+        Arena& operator=(const Arena&) = delete;
+
+        static Arena& Local();
+
+        void* Allocate(size_t bytes, size_t alignment);
+
+        template <typename T>
+        T* Allocate(size_t count) {
+            return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+        }
+
+        std::string_view Copy(std::string_view text);
+
+        size_t capacity() const;
+    };
+
+    // Rewinds this thread's arena to where it stood when the scope began.
+    class ArenaScope {
+    private:
+        Arena& arena_;
+        size_t block_;
+        size_t used_;
+
+    public:
+        ArenaScope();
+
+        ArenaScope(const ArenaScope&) = delete;
+
+        ArenaScope& operator=(const ArenaScope&) = delete;
+
+        ~ArenaScope();
+    };
+
+    template <typename T>
+    class ArenaAllocator {
+    private:
+        Arena* arena_;
+
+    public:
+        using value_type = T;
+
+        ArenaAllocator()
+                : arena_(&Arena::Local())
+        {}
+
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other)
+                : arena_(other.arena())
+        {}
+
+        Arena* arena() const {
+            return arena_;
+        }
+
+        T* allocate(size_t count) {
+            return arena_->Allocate<T>(count);
+        }
+
+        void deallocate(T*, size_t) {}
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U>& other) const {
+            return arena_ == other.arena();
+        }
+
+        template <typename U>
+        bool operator!=(const ArenaAllocator<U>& other) const {
+            return arena_ != other.arena();
+        }
+    };
+
+    template <typename T>
+    using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}
@@ -1,7 +1,115 @@
 #include "database.h"
+#include "aggregate.h"
+#include "arena.h"
+#include "join.h"
+#include "loader.h"
+#include "metrics.h"
+#include "predicate.h"
+#include "profile.h"
+#include "sort.h"
+#include "snapshot.h"
+#include "thread_pool.h"
+#include "wal.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <unistd.h>
 
 using namespace DB;
 
+Bitmap::Bitmap(size_t size, bool value)
+        : words_((size + 63) / 64, value ? ~uint64_t(0) : 0)
+        , size_(size)
+{
+    if (value && size % 64 != 0)
+        words_.Mutable(words_.size() - 1) >>= 64 - size % 64;
+}
+
+size_t Bitmap::Size() const {
+    return size_;
+}
+
+bool Bitmap::Get(size_t index) const {
+    return (words_[index / 64] >> (index % 64)) & 1;
+}
+
+void Bitmap::Set(size_t index, bool value) {
+    if (value)
+        words_.Mutable(index / 64) |= uint64_t(1) << (index % 64);
+    else
+        words_.Mutable(index / 64) &= ~(uint64_t(1) << (index % 64));
+}
+
+size_t Bitmap::Count() const {
+    size_t count = 0;
+    for (size_t i = 0; i < words_.size(); ++i) {
+        count += __builtin_popcountll(words_[i]);
+    }
+
+    return count;
+}
+
+size_t Bitmap::Next(size_t index) const {
+    if (index >= size_)
+        return size_;
+    size_t word = index / 64;
+    uint64_t bits = words_[word] & (~uint64_t(0) << (index % 64));
+    while (bits == 0) {
+        if (++word == words_.size())
+            return size_;
+        bits = words_[word];
+    }
+
+    return std::min(size_, word * 64 + __builtin_ctzll(bits));
+}
+
+const uint64_t* Bitmap::words() const {
+    return words_.data();
+}
+
+uint64_t* Bitmap::MutableWords() {
+    return words_.MutableData();
+}
+
+void Bitmap::PushBack(bool value) {
+    if (size_ % 64 == 0)
+        words_.push_back(0);
+    ++size_;
+    Set(size_ - 1, value);
+}
+
+void Bitmap::Reserve(size_t size) {
+    words_.reserve((size + 63) / 64);
+}
+
+void Bitmap::Clear() {
+    words_.clear();
+    size_ = 0;
+}
+
+size_t Bitmap::MemoryUsage() const {
+    return words_.MemoryUsage();
+}
+
+void Bitmap::Save(Snapshot& snapshot) const {
+    snapshot.catalog().PutNumber(size_);
+    snapshot.PutArray(words_);
+}
+
+bool Bitmap::Load(Snapshot& snapshot) {
+    uint64_t size;
+    if (!snapshot.catalog().GetNumber(size) || !snapshot.GetArray(words_) || words_.size() != (size + 63) / 64)
+        return false;
+    size_ = size;
+
+    return true;
+}
+
 Types Column::type() const {
     return type_;
 }
@@ -18,519 +126,2372 @@ void Column::CheckWidth(int width) {
     width_ = std::max(width, width_);
 }
 
-const std::string& Condition::symbol() const {
-    return symbol_;
+size_t Column::Size() const {
+    return nulls_.Size();
 }
 
-const std::string& Condition::lhs() const {
-    return lhs_;
+size_t Column::MemoryUsage() const {
+    return nulls_.MemoryUsage() + ints_.MemoryUsage() + doubles_.MemoryUsage() + bools_.MemoryUsage() +
+           offsets_.MemoryUsage() + bytes_.MemoryUsage() + codes_.MemoryUsage() + slots_.MemoryUsage();
 }
 
-const std::string& Condition::rhs() const {
-    return rhs_;
+bool Column::IsNull(size_t index) const {
+    return nulls_.Get(index);
 }
 
-void Row::Concatenate(const Row& lhs, const Row& rhs) {
-    for (const auto& elem : lhs.data_) {
-        Set(elem.first, elem.second);
-    }
-    for (const auto& elem : rhs.data_) {
-        Set(elem.first, elem.second);
-    }
+int64_t Column::GetInt(size_t index) const {
+    return ints_[index];
 }
 
-std::string Row::Get(const std::string& name) {
-    return data_[name];
+double Column::GetDouble(size_t index) const {
+    return doubles_[index];
 }
 
-void Row::Set(const std::string& name, const std::string& value) {
-    if (data_.find(name) != data_.end())
-        data_[name] = value;
+bool Column::GetBool(size_t index) const {
+    return bools_.Get(index);
 }
 
-bool Row::Suites(const std::map<std::string, Column>& columns) const {
-    for (auto& elem : data_) {
-        if (columns.find(elem.first) == columns.end())
-            return false;
-    }
-    if (data_.size() == columns.size())
-        return true;
-    return false;
+std::string_view Column::GetText(size_t index) const {
+    if (encoded_)
+        return Entry(codes_[index]);
+
+    return {bytes_.data() + offsets_[index], offsets_[index + 1] - offsets_[index]};
 }
 
-size_t Table::Size() {
-    return rows_.size();
+const Bitmap& Column::nulls() const {
+    return nulls_;
 }
 
-std::map<std::string, Column> Table::columns() {
-    return columns_;
+const int64_t* Column::ints() const {
+    return ints_.data();
 }
 
-const Row& Table::GetRow(int index) {
-    return rows_[index];
+const double* Column::doubles() const {
+    return doubles_.data();
 }
 
-void Table::AddRow(const Row& row) {
-    if (row.Suites(columns_))
-        rows_.emplace_back(row);
+const Bitmap& Column::bools() const {
+    return bools_;
 }
 
-void Table::Insert(std::vector<std::string> columns, const std::vector<std::string>& values) {
-    Row new_row(columns_);
-    if (columns[0].empty()) {
-        columns.clear();
-        for (auto column : columns_) {
-            columns.emplace_back(column.first);
-        }
-    }
-    for (int i = 0; i < columns.size(); ++i) {
-        new_row.Set(columns[i], values[i]);
-        columns_[columns[i]].CheckWidth(values[i].size());
-    }
-    rows_.emplace_back(new_row);
+bool Column::encoded() const {
+    return encoded_;
+}
 
-    std::cout << std::endl << "-- INSERTED " <<  values.size() << " VALUES --\n" << std::endl;
+const uint32_t* Column::codes() const {
+    return codes_.data();
 }
 
-std::string Table::Get(int index, const std::string& name) {
-    if (IsColumnName(name))
-        return rows_[index].Get(name);
-    else
-        return name;
+size_t Column::entries() const {
+    return offsets_.size() - 1;
 }
 
-Types Table::GetType(const std::string& name) {
-    return columns_[name].type();
+std::string_view Column::Entry(uint32_t code) const {
+    return {bytes_.data() + offsets_[code], offsets_[code + 1] - offsets_[code]};
 }
 
-bool Table::IsColumnName(const std::string& value) {
-    for (auto& column : columns_) {
-        if (column.first == value)
-            return true;
+// Slots are saved in snapshots, so the hash must not change between builds or runs: FNV-1a.
+static uint64_t HashEntry(std::string_view value) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : value) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
     }
 
-    return false;
+    return hash;
 }
 
-void Table::Delete(const std::vector<bool>& selected) {
-    int counter = 0;
-    for (int i = 0; i < selected.size(); ++i) {
-        if (selected[i]) {
-            rows_.erase(rows_.begin() + i);
-            ++counter;
-        }
+uint32_t Column::Code(std::string_view value) const {
+    if (slots_.size() == 0)
+        return kNoCode;
+    size_t mask = slots_.size() - 1;
+    for (size_t slot = HashEntry(value) & mask;; slot = (slot + 1) & mask) {
+        if (slots_[slot] == 0)
+            return kNoCode;
+        if (Entry(slots_[slot] - 1) == value)
+            return slots_[slot] - 1;
     }
-    std::cout << std::endl << "-- DELETED " << counter << " ROWS --\n" << std::endl;
 }
 
-void Table::UpdateWidth(const std::string& name) {
-    columns_[name].SetWidth(0);
-    for (auto& row : rows_) {
-        columns_[name].CheckWidth(row.Get(name).size());
+uint32_t Column::Intern(std::string_view value) {
+    if (slots_.size() < 2 * (entries() + 1))
+        Rehash(2 * (entries() + 1));
+    size_t mask = slots_.size() - 1;
+    for (size_t slot = HashEntry(value) & mask;; slot = (slot + 1) & mask) {
+        if (slots_[slot] == 0) {
+            bytes_.append(value.data(), value.size());
+            offsets_.push_back(bytes_.size());
+            slots_.Mutable(slot) = entries();
+            return entries() - 1;
+        }
+        if (Entry(slots_[slot] - 1) == value)
+            return slots_[slot] - 1;
     }
 }
 
-void Table::Update(const std::vector<std::pair<std::string, std::string>>& values, const std::vector<bool>& selected) {
-    int counter = 0;
-    for (int i = 0; i < selected.size(); ++i) {
-        if (selected[i]) {
-            for (auto& pair : values) {
-                rows_[i].Set(pair.first, pair.second);
-            }
-            ++counter;
+// Slots hold a code plus one and zero when empty; there are at least twice capacity of them.
+void Column::Rehash(size_t capacity) {
+    size_t slots = 64;
+    while (slots < 2 * capacity) {
+        slots *= 2;
+    }
+    std::vector<uint32_t> table(slots, 0);
+    for (uint32_t code = 0; code < entries(); ++code) {
+        size_t slot = HashEntry(Entry(code)) & (slots - 1);
+        while (table[slot] != 0) {
+            slot = (slot + 1) & (slots - 1);
         }
+        table[slot] = code + 1;
     }
-    for (auto& pair : values) {
-        UpdateWidth(pair.first);
+    slots_ = Buffer<uint32_t>(std::move(table));
+}
+
+void Column::Decode() {
+    Buffer<uint64_t> offsets = {0};
+    Buffer<char> bytes;
+    offsets.reserve(codes_.size() + 1);
+    for (size_t i = 0; i < codes_.size(); ++i) {
+        std::string_view entry = Entry(codes_[i]);
+        bytes.append(entry.data(), entry.size());
+        offsets.push_back(bytes.size());
+    }
+    offsets_ = std::move(offsets);
+    bytes_ = std::move(bytes);
+    codes_ = Buffer<uint32_t>();
+    slots_ = Buffer<uint32_t>();
+    encoded_ = false;
+}
+
+static std::string EncodeKey(int64_t value) {
+    uint64_t bits = static_cast<uint64_t>(value) ^ (uint64_t(1) << 63);
+    std::string result(sizeof(bits), '\0');
+    for (int i = 0; i < 8; ++i) {
+        result[i] = static_cast<char>(bits >> (56 - 8 * i));
     }
-    std::cout << std::endl << "-- UPDATED " << counter << " ROWS --\n" << std::endl;
+
+    return result;
 }
 
-void MyAwesomeDB::StripSpaces(std::string& str) {
-    str.erase(remove_if(str.begin(), str.end(), isspace), str.end());
+static std::string EncodeKey(double value) {
+    uint64_t bits;
+    value = value == 0 ? 0 : value;
+    std::memcpy(&bits, &value, sizeof(bits));
+    bits = (bits >> 63) ? ~bits : bits | (uint64_t(1) << 63);
+
+    return EncodeKey(static_cast<int64_t>(bits ^ (uint64_t(1) << 63)));
+}
+
+std::string Column::Key(size_t index) const {
+    if (type_ == INT)
+        return EncodeKey(ints_[index]);
+    else if (type_ == DOUBLE)
+        return EncodeKey(doubles_[index]);
+    else if (type_ == BOOL)
+        return std::string(1, bools_.Get(index) ? '\1' : '\0');
+
+    return std::string(GetText(index));
 }
 
-std::string MyAwesomeDB::GetColumnName(const std::string& value) {
-    std::smatch match;
-    if (std::regex_search(value, match, reg_dot_separated))
-        return match[2];
+std::string Column::MakeKey(Types type, const std::string& value) {
+    if (type == INT)
+        return EncodeKey(static_cast<int64_t>(std::stoll(value)));
+    else if (type == DOUBLE)
+        return EncodeKey(std::stod(value));
+    else if (type == BOOL)
+        return std::string(1, value == "1" || value == "TRUE" || value == "true" ? '\1' : '\0');
+
     return value;
 }
 
-std::string MyAwesomeDB::MakeDivider(const std::string& table, const std::vector<std::string>& columns) {
+std::string Column::ToString(size_t index) const {
     std::string result;
-    int width;
-    result = "+";
-    for (auto& name : columns) {
-        width = tables_[table]->columns()[GetColumnName(name)].width();
-        for (int i = 0; i < width + 2; ++i) {
-            result += "-";
-        }
-        result += "+";
-    }
+    Render(index, result);
 
     return result;
 }
 
-std::vector<std::string> MyAwesomeDB::MakeOutput(const std::string& table, std::vector<std::string> columns,
-                                                 const std::vector<bool>& selected, bool select_all = false) {
-    for (auto& elem : columns) {
-        StripSpaces(elem);
+void Column::Render(size_t index, std::string& out) const {
+    if (IsNull(index))
+        return;
+    if (type_ == INT || type_ == DOUBLE) {
+        char buffer[32];
+        auto result = type_ == INT ? std::to_chars(buffer, buffer + sizeof(buffer), ints_[index])
+                                   : std::to_chars(buffer, buffer + sizeof(buffer), doubles_[index]);
+        out.append(buffer, result.ptr);
+    } else if (type_ == BOOL) {
+        out += bools_.Get(index) ? '1' : '0';
+    } else {
+        out.append(GetText(index));
     }
-    if (columns[0] == "*" && columns.size() == 1) {
-        columns.clear();
-        for (auto& column : tables_[table]->columns()) {
-            columns.emplace_back(column.first);
-        }
+}
+
+bool Column::IsValid(Types type, const std::string& value) {
+    const char* end = value.data() + value.size();
+    if (type == INT) {
+        int64_t result;
+        auto parsed = std::from_chars(value.data() + (!value.empty() && value[0] == '+'), end, result);
+        return !value.empty() && parsed.ec == std::errc() && parsed.ptr == end;
+    } else if (type == DOUBLE) {
+        double result;
+        auto parsed = std::from_chars(value.data() + (!value.empty() && value[0] == '+'), end, result);
+        return !value.empty() && parsed.ec == std::errc() && parsed.ptr == end;
+    } else if (type == BOOL) {
+        return value == "1" || value == "0" || value == "TRUE" || value == "FALSE" || value == "true" ||
+               value == "false";
     }
-    std::vector<std::string> output;
-    std::string row = "| ";
-    int width;
-    std::string divider = MakeDivider(table, columns);
-    output.emplace_back(divider);
-    for (auto& name : columns) {
-        if (tables_[table]->columns().find(GetColumnName(name)) == tables_[table]->columns().end())
-            continue;
-        width = tables_[table]->columns()[GetColumnName(name)].width();
-        row += GetColumnName(name);
-        for (int i = 0; i < width - GetColumnName(name).size(); ++i) {
-            row += " ";
-        }
-        row += " | ";
-    }
-    output.emplace_back(row);
-    output.emplace_back(divider);
-    for (int i = 0; i < tables_[table]->Size(); ++i) {
-        if (select_all || selected[i]) {
-            row = "| ";
-            for (auto& name : columns) {
-                if (tables_[table]->columns().find(GetColumnName(name)) == tables_[table]->columns().end())
-                    continue;
-                width = tables_[table]->columns()[GetColumnName(name)].width();
-                row += GetValue({{table, i}, {table, i}}, GetColumnName(name));
-                for (int j = 0; j < width - GetValue({{table, i}, {table, i}}, GetColumnName(name)).size(); ++j) {
-                    row += " ";
-                }
-                row += " | ";
-            }
-            output.emplace_back(row);
-        }
+    return true;
+}
+
+void Column::AppendText(std::string_view value) {
+    if (!encoded_) {
+        bytes_.append(value.data(), value.size());
+        offsets_.push_back(bytes_.size());
+        return;
     }
-    output.emplace_back(divider + "\n");
+    size_t entries_before = entries();
+    codes_.push_back(Intern(value));
+    if (entries() > entries_before && codes_.size() >= kDictionaryMinRows && entries() * 2 > codes_.size())
+        Decode();
+}
 
-    return output;
+void Column::Append(const std::string& value) {
+    nulls_.PushBack(false);
+    if (type_ == INT) {
+        ints_.push_back(std::stoll(value));
+    } else if (type_ == DOUBLE) {
+        doubles_.push_back(std::stod(value));
+    } else if (type_ == BOOL) {
+        bools_.PushBack(value == "1" || value == "TRUE" || value == "true");
+    } else {
+        AppendText(value);
+    }
+    CheckWidth(ToString(Size() - 1).size());
 }
 
-Types MyAwesomeDB::SeeType(const std::string& str) {
-    if (str == "INT")
-        return INT;
-    else if (str == "BOOL")
-        return BOOL;
-    else if (str == "DOUBLE")
-        return DOUBLE;
-    else if (str == "TEXT")
-        return TEXT;
-    return UNKNOWN;
+void Column::AppendNull() {
+    nulls_.PushBack(true);
+    if (type_ == INT) {
+        ints_.push_back(0);
+    } else if (type_ == DOUBLE) {
+        doubles_.push_back(0);
+    } else if (type_ == BOOL) {
+        bools_.PushBack(false);
+    } else {
+        AppendText("");
+    }
 }
 
-void MyAwesomeDB::CreateTable(const std::string& name, const std::vector<std::pair<std::string, std::string>>& columns) {
-    std::map<std::string, Column> columns_;
-    Types type;
-    for (auto& column : columns) {
-        type = SeeType(column.second);
-        columns_.insert({column.first, Column(type, column.first.size())});
+void Column::AppendFrom(const Column& other, size_t index) {
+    if (other.IsNull(index) || other.type_ != type_) {
+        AppendNull();
+        return;
+    }
+    nulls_.PushBack(false);
+    if (type_ == INT) {
+        ints_.push_back(other.ints_[index]);
+    } else if (type_ == DOUBLE) {
+        doubles_.push_back(other.doubles_[index]);
+    } else if (type_ == BOOL) {
+        bools_.PushBack(other.bools_.Get(index));
+    } else {
+        AppendText(other.GetText(index));
+    }
+}
+
+bool Column::Parse(std::string_view value) {
+    char buffer[32];
+    const char* begin = value.data() + (!value.empty() && value[0] == '+');
+    const char* end = value.data() + value.size();
+    if (type_ == INT) {
+        int64_t result;
+        auto parsed = std::from_chars(begin, end, result);
+        if (value.empty() || parsed.ec != std::errc() || parsed.ptr != end)
+            return false;
+        ints_.push_back(result);
+        CheckWidth(std::to_chars(buffer, buffer + sizeof(buffer), result).ptr - buffer);
+    } else if (type_ == DOUBLE) {
+        double result;
+        auto parsed = std::from_chars(begin, end, result);
+        if (value.empty() || parsed.ec != std::errc() || parsed.ptr != end)
+            return false;
+        doubles_.push_back(result);
+        CheckWidth(std::to_chars(buffer, buffer + sizeof(buffer), result).ptr - buffer);
+    } else if (type_ == BOOL) {
+        bool result = value == "1" || value == "TRUE" || value == "true";
+        if (!result && value != "0" && value != "FALSE" && value != "false")
+            return false;
+        bools_.PushBack(result);
+        CheckWidth(1);
+    } else {
+        AppendText(value);
+        CheckWidth(value.size());
     }
+    nulls_.PushBack(false);
 
-    tables_.insert({name, new Table(columns_)});
+    return true;
 }
 
-void MyAwesomeDB::DeleteTable(const std::string& name) {
-    tables_.erase(name);
+void Column::AppendColumn(const Column& other) {
+    for (size_t i = 0; i < other.Size(); ++i) {
+        nulls_.PushBack(other.nulls_.Get(i));
+    }
+    if (type_ == INT) {
+        ints_.append(other.ints_.data(), other.ints_.size());
+    } else if (type_ == DOUBLE) {
+        doubles_.append(other.doubles_.data(), other.doubles_.size());
+    } else if (type_ == BOOL) {
+        for (size_t i = 0; i < other.Size(); ++i) {
+            bools_.PushBack(other.bools_.Get(i));
+        }
+    } else if (encoded_ || other.encoded_) {
+        for (size_t i = 0; i < other.Size(); ++i) {
+            AppendText(other.GetText(i));
+        }
+    } else {
+        uint64_t base = bytes_.size();
+        bytes_.append(other.bytes_.data(), other.bytes_.size());
+        for (size_t i = 1; i < other.offsets_.size(); ++i) {
+            offsets_.push_back(base + other.offsets_[i]);
+        }
+    }
+    CheckWidth(other.width_);
 }
 
-std::vector<std::string> MyAwesomeDB::SelectAll(const std::string& table, const std::vector<std::string>& columns) {
-    if (tables_.find(table) == tables_.end())
-        return {"-- NO TABLE " + table + " FOUND --\n"};
-    std::vector<bool> empty;
+void Column::Reserve(size_t size) {
+    nulls_.Reserve(size);
+    if (type_ == INT)
+        ints_.reserve(size);
+    else if (type_ == DOUBLE)
+        doubles_.reserve(size);
+    else if (type_ == BOOL)
+        bools_.Reserve(size);
+    else if (encoded_)
+        codes_.reserve(size);
+    else
+        offsets_.reserve(size + 1);
+}
 
-    return MakeOutput(table, columns, empty, true);
+void Column::Clear() {
+    nulls_.Clear();
+    ints_.clear();
+    doubles_.clear();
+    bools_.Clear();
+    offsets_.resize(1);
+    bytes_.clear();
+    codes_.clear();
+    slots_.clear();
 }
 
-bool MyAwesomeDB::Check(int lhs, int rhs, const std::string& symbol) {
-    if (symbol == ">") {
-        return lhs > rhs;
-    } else if (symbol == ">=") {
-        return lhs >= rhs;
-    } else if (symbol == "<") {
-        return lhs < rhs;
-    } else if (symbol == "<=") {
-        return lhs <= rhs;
-    } else if (symbol == "=") {
-        return lhs == rhs;
-    } else if (symbol == "!=") {
-        return lhs != rhs;
+void Column::Erase(const Bitmap& selected) {
+    Bitmap nulls;
+    Bitmap bools;
+    size_t kept = 0;
+    uint64_t end = 0;
+    int64_t* ints = type_ == INT ? ints_.MutableData() : nullptr;
+    double* doubles = type_ == DOUBLE ? doubles_.MutableData() : nullptr;
+    uint32_t* codes = encoded_ ? codes_.MutableData() : nullptr;
+    uint64_t* offsets = (type_ == TEXT || type_ == UNKNOWN) && !encoded_ ? offsets_.MutableData() : nullptr;
+    char* bytes = (type_ == TEXT || type_ == UNKNOWN) && !encoded_ ? bytes_.MutableData() : nullptr;
+    for (size_t i = 0; i < Size(); ++i) {
+        if (selected.Get(i))
+            continue;
+        nulls.PushBack(nulls_.Get(i));
+        if (type_ == INT) {
+            ints[kept] = ints[i];
+        } else if (type_ == DOUBLE) {
+            doubles[kept] = doubles[i];
+        } else if (type_ == BOOL) {
+            bools.PushBack(bools_.Get(i));
+        } else if (encoded_) {
+            codes[kept] = codes[i];
+        } else {
+            uint64_t length = offsets[i + 1] - offsets[i];
+            std::memmove(bytes + end, bytes + offsets[i], length);
+            end += length;
+            offsets[kept + 1] = end;
+        }
+        ++kept;
+    }
+    nulls_ = std::move(nulls);
+    bools_ = std::move(bools);
+    if (type_ == INT) {
+        ints_.resize(kept);
+    } else if (type_ == DOUBLE) {
+        doubles_.resize(kept);
+    } else if (encoded_) {
+        codes_.resize(kept);
+    } else if (type_ != BOOL) {
+        offsets_.resize(kept + 1);
+        bytes_.resize(end);
     }
-    return false;
 }
 
-bool MyAwesomeDB::Check(bool lhs, bool rhs, const std::string& symbol) {
-    if (symbol == ">") {
-        return lhs > rhs;
-    } else if (symbol == ">=") {
-        return lhs >= rhs;
-    } else if (symbol == "<") {
-        return lhs < rhs;
-    } else if (symbol == "<=") {
-        return lhs <= rhs;
-    } else if (symbol == "=") {
-        return lhs == rhs;
-    } else if (symbol == "!=") {
-        return lhs != rhs;
+void Column::Save(Snapshot& snapshot) const {
+    snapshot.catalog().PutNumber(type_);
+    snapshot.catalog().PutNumber(width_);
+    nulls_.Save(snapshot);
+    if (type_ == INT) {
+        snapshot.PutArray(ints_);
+    } else if (type_ == DOUBLE) {
+        snapshot.PutArray(doubles_);
+    } else if (type_ == BOOL) {
+        bools_.Save(snapshot);
+    } else {
+        snapshot.catalog().PutNumber(encoded_);
+        if (encoded_)
+            snapshot.PutArray(codes_);
+        snapshot.PutArray(offsets_);
+        snapshot.PutArray(bytes_);
+        if (encoded_)
+            snapshot.PutArray(slots_);
     }
-    return false;
 }
 
-bool MyAwesomeDB::Check(double lhs, double rhs, const std::string& symbol) {
-    if (symbol == ">") {
-        return lhs > rhs;
-    } else if (symbol == ">=") {
-        return lhs >= rhs;
-    } else if (symbol == "<") {
-        return lhs < rhs;
-    } else if (symbol == "<=") {
-        return lhs <= rhs;
-    } else if (symbol == "=") {
-        return lhs == rhs;
-    } else if (symbol == "!=") {
-        return lhs != rhs;
+bool Column::Load(Snapshot& snapshot) {
+    uint64_t type;
+    uint64_t width;
+    if (!snapshot.catalog().GetNumber(type) || !snapshot.catalog().GetNumber(width) || type > UNKNOWN ||
+        !nulls_.Load(snapshot))
+        return false;
+    type_ = static_cast<Types>(type);
+    width_ = static_cast<int>(width);
+    if (type_ == INT)
+        return snapshot.GetArray(ints_) && ints_.size() == Size();
+    else if (type_ == DOUBLE)
+        return snapshot.GetArray(doubles_) && doubles_.size() == Size();
+    else if (type_ == BOOL)
+        return bools_.Load(snapshot) && bools_.Size() == Size();
+    uint64_t encoded = 0;
+    if (snapshot.version() > 1 && !snapshot.catalog().GetNumber(encoded))
+        return false;
+    encoded_ = encoded != 0;
+    if (encoded_ && (!snapshot.GetArray(codes_) || codes_.size() != Size()))
+        return false;
+    if (snapshot.version() < 4) {
+        // Offsets were 32-bit before version 4, so widen them; only such snapshots read them all at open.
+        Buffer<uint32_t> narrow;
+        if (!snapshot.GetArray(narrow))
+            return false;
+        offsets_ = Buffer<uint64_t>(std::vector<uint64_t>(narrow.data(), narrow.data() + narrow.size()));
+    } else if (!snapshot.GetArray(offsets_)) {
+        return false;
     }
-    return false;
+    if (!snapshot.GetArray(bytes_) || offsets_.size() == 0 ||
+        (!encoded_ && offsets_.size() != Size() + 1) || offsets_[offsets_.size() - 1] > bytes_.size())
+        return false;
+    if (!encoded_)
+        return true;
+    // Version 2 snapshots have no slots; later ones map them, so opening reads neither the codes nor the entries.
+    if (snapshot.version() < 3) {
+        Rehash(entries());
+        return true;
+    }
+    if (!snapshot.GetArray(slots_))
+        return false;
+    size_t slots = slots_.size();
+
+    return slots >= 2 * entries() && (slots & (slots - 1)) == 0;
 }
 
-bool MyAwesomeDB::Check(const std::string& lhs, const std::string& rhs, const std::string& symbol) {
-    if (symbol == ">") {
-        return lhs > rhs;
-    } else if (symbol == ">=") {
-        return lhs >= rhs;
-    } else if (symbol == "<") {
-        return lhs < rhs;
-    } else if (symbol == "<=") {
-        return lhs <= rhs;
-    } else if (symbol == "=") {
-        return lhs == rhs;
-    } else if (symbol == "!=") {
-        return lhs != rhs;
-    }
-    return false;
+const std::string& Condition::symbol() const {
+    return symbol_;
+}
+
+const std::string& Condition::lhs() const {
+    return lhs_;
+}
+
+const std::string& Condition::rhs() const {
+    return rhs_;
+}
+
+size_t Ordering::needed() const {
+    return limit > SIZE_MAX - offset ? SIZE_MAX : limit + offset;
+}
+
+std::string Aggregate::Name() const {
+    static const char* kFunctions[] = {"", "COUNT", "SUM", "AVG", "MIN", "MAX"};
+    if (function == AGGREGATE_NONE)
+        return column;
+    size_t dot = column.find('.');
+
+    return std::string(kFunctions[function]) + "(" + (dot == std::string::npos ? column : column.substr(dot + 1)) +
+           ")";
+}
+
+const std::string& Index::column() const {
+    return column_;
+}
+
+void Index::Insert(const std::string& key, size_t row) {
+    entries_.emplace(key, row);
 }
 
-std::string MyAwesomeDB::GetValue(std::map<std::string, int> indexes, std::string name) {
-    std::smatch match;
-    std::string table = indexes.begin()->first;
-    if (std::regex_search(name, match, reg_dot_separated)) {
-        table = match[1];
-        name = match[2];
+void Index::Erase(const std::string& key, size_t row) {
+    auto range = entries_.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == row) {
+            entries_.erase(it);
+            return;
+        }
     }
+}
 
-    return tables_[table]->Get(indexes[table], name);
+void Index::Clear() {
+    entries_.clear();
 }
 
-Types MyAwesomeDB::GetType(std::string table, std::string name) {
-    std::smatch match;
-    if (std::regex_search(name, match, reg_dot_separated)) {
-        table = match[1];
-        name = match[2];
+void Index::Range(const KeyRange& range, std::vector<size_t>& rows) const {
+    auto begin = entries_.begin();
+    auto end = entries_.end();
+    if (range.has_lower)
+        begin = range.lower_inclusive ? entries_.lower_bound(range.lower) : entries_.upper_bound(range.lower);
+    if (range.has_upper)
+        end = range.upper_inclusive ? entries_.upper_bound(range.upper) : entries_.lower_bound(range.upper);
+    if (range.has_lower && range.has_upper && range.upper < range.lower)
+        return;
+    for (auto it = begin; it != end; ++it) {
+        rows.emplace_back(it->second);
     }
+}
 
-    return tables_[table]->GetType(name);
+bool ReadView::Sees(uint64_t creator) const {
+    return creator == xid || (creator < limit && !std::binary_search(active.begin(), active.end(), creator));
 }
 
-bool MyAwesomeDB::CheckCondition(const std::map<std::string, int>& indexes, const std::string& lhs,
-                                 const std::string& rhs, const std::string& symbol) {
-    Types type = GetType(indexes.begin()->first, lhs);
-    std::string lhs_value = GetValue(indexes, lhs);
-    std::string rhs_value = GetValue(indexes, rhs);
-    if (type == INT) {
-        return Check(std::stoi(lhs_value), std::stoi(rhs_value), symbol);
-    } else if (type == BOOL) {
-        return Check(lhs_value == "1", rhs_value == "1", symbol);
-    } else if (type == DOUBLE) {
-        return Check(std::stof(lhs_value), std::stof(rhs_value), symbol);
-    } else if (type == TEXT) {
-        return Check(lhs_value, rhs_value, symbol);
+uint64_t ReadView::Horizon() const {
+    return active.empty() ? limit : std::min(limit, active.front());
+}
+
+size_t Table::Size() {
+    return size_;
+}
+
+const std::map<std::string, Column>& Table::columns() const {
+    return columns_;
+}
+
+const Column& Table::GetColumn(const std::string& name) const {
+    return columns_.at(name);
+}
+
+const std::string& Table::primary_key() const {
+    return primary_key_;
+}
+
+std::shared_mutex& Table::latch() const {
+    return latch_;
+}
+
+void Table::Pin() {
+    ++pins_;
+}
+
+void Table::Unpin() {
+    --pins_;
+}
+
+bool Table::pinned() const {
+    return pins_ > 0;
+}
+
+void Table::RebuildIndexes() {
+    if (!primary_key_.empty()) {
+        primary_index_.clear();
+        primary_index_.reserve(size_);
+        auto& key = columns_[primary_key_];
+        for (size_t i = 0; i < size_; ++i) {
+            if (xmin_[i] != kNever)
+                primary_index_.emplace(key.Key(i), i);
+        }
+    }
+    for (auto& index : indexes_) {
+        auto& column = columns_[index.second.column()];
+        index.second.Clear();
+        for (size_t i = 0; i < size_; ++i) {
+            if (xmin_[i] != kNever && !column.IsNull(i))
+                index.second.Insert(column.Key(i), i);
+        }
     }
 }
 
-bool MyAwesomeDB::CheckRow(const std::map<std::string, int>& indexes,
-                           const std::vector<std::vector<Condition>>& conditions) {
-    bool result = false;
-    bool AND_result;
-    bool tmp;
-    for (auto& AND_separated : conditions) {
-        AND_result = CheckCondition(indexes, AND_separated[0].lhs(), AND_separated[0].rhs(),
-                                    AND_separated[0].symbol());
-        for (int i = 1; i < AND_separated.size(); ++i) {
-            tmp = CheckCondition(indexes, AND_separated[i].lhs(), AND_separated[i].rhs(),
-                                 AND_separated[i].symbol());
-            AND_result = AND_result && tmp;
+bool Table::Lookup(const Predicate& predicate, std::vector<size_t>& rows) const {
+    std::vector<std::string> keys;
+    std::vector<KeyRange> ranges;
+    if (!primary_key_.empty() && predicate.EqualityKeys(&columns_.at(primary_key_), keys)) {
+        for (auto& key : keys) {
+            auto range = primary_index_.equal_range(key);
+            for (auto row = range.first; row != range.second; ++row) {
+                rows.emplace_back(row->second);
+            }
+        }
+    } else {
+        auto index = indexes_.begin();
+        for (; index != indexes_.end(); ++index) {
+            ranges.clear();
+            if (predicate.Ranges(&columns_.at(index->second.column()), ranges))
+                break;
+        }
+        if (index == indexes_.end())
+            return false;
+        for (auto& range : ranges) {
+            index->second.Range(range, rows);
         }
-        result = result || AND_result;
     }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
 
-    return result;
+    return true;
 }
-
-std::vector<bool> MyAwesomeDB::GetRows(const std::string& table, const std::vector<std::vector<Condition>>& conditions) {
-    std::vector<bool> result(tables_[table]->Size(), false);
-    for (int i = 0; i < result.size(); ++i) {
-        result[i] = CheckRow({{table, i}, {table, i}}, conditions);
+std::string Table::AccessPath(const Predicate& predicate) const {
+    std::vector<std::string> keys;
+    std::vector<KeyRange> ranges;
+    if (!primary_key_.empty() && predicate.EqualityKeys(&columns_.at(primary_key_), keys))
+        return "primary key " + primary_key_;
+    for (auto& index : indexes_) {
+        ranges.clear();
+        if (predicate.Ranges(&columns_.at(index.second.column()), ranges))
+            return "index " + index.first + " on " + index.second.column();
     }
 
-    return result;
+    return "";
 }
 
-std::vector<std::string> MyAwesomeDB::Select(const std::string& table, const std::vector<std::string>& columns,
-                                const std::vector<std::vector<Condition>>& conditions) {
-    if (tables_.find(table) == tables_.end())
-        return {"-- NO TABLE " + table + " FOUND --\n"};
-    auto selected = GetRows(table, conditions);
+bool Table::HasIndex(const std::string& name) const {
+    return indexes_.find(name) != indexes_.end();
+}
 
-    return MakeOutput(table, columns, selected);
+void Table::CreateIndex(const std::string& name, const std::string& column) {
+    indexes_.insert({name, Index(column)});
+    RebuildIndexes();
 }
 
-void MyAwesomeDB::Insert(const std::string& table, const std::vector<std::string>& columns, const std::vector<std::string>& values) {
-    if (tables_.find(table) == tables_.end()) {
-        std::cout << "-- NO TABLE " + table + " FOUND --\n" << std::endl;
-        return;
+void Table::DropIndex(const std::string& name) {
+    indexes_.erase(name);
+}
+
+void Table::AppendJoined(Table* lhs, int l, Table* rhs, int r) {
+    for (auto& column : columns_) {
+        if (r >= 0 && rhs->IsColumnName(column.first))
+            column.second.AppendFrom(rhs->GetColumn(column.first), r);
+        else if (lhs->IsColumnName(column.first))
+            column.second.AppendFrom(lhs->GetColumn(column.first), l);
+        else
+            column.second.AppendNull();
     }
-    tables_[table]->Insert(columns, values);
+    xmin_.push_back(0);
+    xmax_.push_back(kNever);
+    ++size_;
 }
 
-void MyAwesomeDB::Delete(const std::string& table, const std::vector<std::vector<Condition>>& conditions) {
-    if (tables_.find(table) == tables_.end()) {
-        std::cout << "-- NO TABLE " + table + " FOUND --\n" << std::endl;
-        return;
+void Table::Clear() {
+    for (auto& column : columns_) {
+        column.second.Clear();
     }
-    auto selected = GetRows(table, conditions);
-    tables_[table]->Delete(selected);
+    xmin_.clear();
+    xmax_.clear();
+    size_ = 0;
+    dead_ = 0;
 }
 
-void MyAwesomeDB::Update(const std::string& table, const std::vector<std::pair<std::string, std::string>>& values,
-            const std::vector<std::vector<Condition>>& conditions) {
-    if (tables_.find(table) == tables_.end()) {
-        std::cout << "-- NO TABLE " + table + " FOUND --\n" << std::endl;
-        return;
+bool Table::Insert(std::vector<std::string> columns, const std::vector<std::vector<std::string>>& rows,
+                   const ReadView& view, std::string& message) {
+    if (columns[0].empty()) {
+        columns.clear();
+        for (auto& column : columns_) {
+            columns.emplace_back(column.first);
+        }
+    }
+    for (auto& values : rows) {
+        if (columns.size() != values.size()) {
+            message = "-- EXPECTED " + std::to_string(columns.size()) + " VALUES, GOT " +
+                      std::to_string(values.size()) + " --\n";
+            return false;
+        }
+    }
+    std::vector<std::vector<Column>> batches(1);
+    auto& batch = batches[0];
+    for (auto& name : columns) {
+        if (!IsColumnName(name)) {
+            message = "-- NO COLUMN " + name + " FOUND --\n";
+            return false;
+        }
+        batch.emplace_back(columns_[name].type(), 0, false);
+        batch.back().Reserve(rows.size());
     }
-    auto selected = GetRows(table, conditions);
-    tables_[table]->Update(values, selected);
-}
-
-Table* MyAwesomeDB::InnerJoin(const std::string& table_l, const std::string& table_r, const std::vector<std::vector<Condition>>& join_on) {
-    int size_l = tables_[table_l]->Size();
-    int size_r = tables_[table_r]->Size();
-    std::map<std::string, Column> new_columns;
-    new_columns = tables_[table_l]->columns();
-    for (auto& column : tables_[table_r]->columns()) {
-        if (new_columns.find(column.first) == new_columns.end())
-            new_columns.insert(column);
-    }
-    auto new_table = new Table(new_columns);
-    for (int l = 0; l < size_l; ++l) {
-        for (int r = 0; r < size_r; ++r) {
-            if (CheckRow({{table_l, l}, {table_r, r}}, join_on)) {
-                auto new_row = Row(new_columns);
-                new_row.Concatenate(tables_[table_l]->GetRow(l), tables_[table_r]->GetRow(r));
-                new_table->AddRow(new_row);
+    for (auto& values : rows) {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (!batch[i].Parse(values[i])) {
+                message = "-- INVALID VALUE " + values[i] + " FOR COLUMN " + columns[i] + " --\n";
+                return false;
             }
         }
     }
+    if (!Append(columns, batches, view, message))
+        return false;
 
-    return new_table;
+    if (rows.size() == 1)
+        message = "\n-- INSERTED " + std::to_string(rows[0].size()) + " VALUES --\n";
+    else
+        message = "\n-- INSERTED " + std::to_string(rows.size()) + " ROWS --\n";
+    return true;
 }
 
-Table* MyAwesomeDB::LeftJoin(const std::string& table_l, const std::string& table_r, const std::vector<std::vector<Condition>>& join_on) {
-    int size_l = tables_[table_l]->Size();
-    int size_r = tables_[table_r]->Size();
-    std::map<std::string, Column> new_columns;
-    new_columns = tables_[table_l]->columns();
-    for (auto& column : tables_[table_r]->columns()) {
-        if (new_columns.find(column.first) == new_columns.end())
-            new_columns.insert(column);
+bool Table::Append(const std::vector<std::string>& columns, const std::vector<std::vector<Column>>& batches,
+                   const ReadView& view, std::string& message) {
+    size_t count = 0;
+    for (auto& batch : batches) {
+        count += batch.empty() ? 0 : batch[0].Size();
+    }
+    if (!primary_key_.empty() && count > 0) {
+        size_t position = std::find(columns.begin(), columns.end(), primary_key_) - columns.begin();
+        if (position == columns.size()) {
+            message = "-- PRIMARY KEY " + primary_key_ + " CANNOT BE NULL --\n";
+            return false;
+        }
+        std::unordered_set<std::string> keys;
+        if (count > 1)
+            keys.reserve(count);
+        for (auto& batch : batches) {
+            auto& key = batch[position];
+            for (size_t i = 0; i < key.Size(); ++i) {
+                if (key.IsNull(i)) {
+                    message = "-- PRIMARY KEY " + primary_key_ + " CANNOT BE NULL --\n";
+                    return false;
+                }
+                std::string encoded = key.Key(i);
+                bool taken = false;
+                bool concurrent = false;
+                auto range = primary_index_.equal_range(encoded);
+                for (auto row = range.first; row != range.second && !taken; ++row) {
+                    taken = IsVisible(row->second, view);
+                    // A live version the snapshot cannot see was inserted by a transaction that committed since.
+                    concurrent = concurrent || (xmin_[row->second] != kNever && xmax_[row->second] == kNever &&
+                                                !view.Sees(xmin_[row->second]));
+                }
+                if (concurrent && !taken) {
+                    message = "-- SERIALIZATION FAILURE: ROW CHANGED BY A CONCURRENT TRANSACTION --\n";
+                    return false;
+                }
+                if (taken || (count > 1 && !keys.insert(std::move(encoded)).second)) {
+                    message = "-- DUPLICATE PRIMARY KEY " + key.ToString(i) + " --\n";
+                    return false;
+                }
+            }
+        }
     }
-    auto new_table = new Table(new_columns);
-    Row new_row;
-    bool found;
-    for (int l = 0; l < size_l; ++l) {
-        found = false;
-        for (int r = 0; r < size_r; ++r) {
-            if (CheckRow({{table_l, l}, {table_r, r}}, join_on)) {
-                new_row = Row(new_columns);
-                new_row.Concatenate(tables_[table_l]->GetRow(l), tables_[table_r]->GetRow(r));
-                new_table->AddRow(new_row);
-                found = true;
+    for (auto& column : columns_) {
+        column.second.Reserve(size_ + count);
+        size_t position = std::find(columns.begin(), columns.end(), column.first) - columns.begin();
+        if (position == columns.size()) {
+            for (size_t i = 0; i < count; ++i) {
+                column.second.AppendNull();
             }
+            continue;
+        }
+        for (auto& batch : batches) {
+            column.second.AppendColumn(batch[position]);
         }
-        if (!found) {
-            new_row = Row(new_columns);
-            new_row.Concatenate(Row(tables_[table_r]->columns()), tables_[table_l]->GetRow(l));
-            new_table->AddRow(new_row);
+    }
+    size_t first = size_;
+    newest_ = std::max(newest_, view.xid);
+    xmin_.reserve(size_ + count);
+    xmax_.reserve(size_ + count);
+    for (size_t i = 0; i < count; ++i) {
+        xmin_.push_back(view.xid);
+        xmax_.push_back(kNever);
+    }
+    size_ += count;
+    if (!primary_key_.empty()) {
+        auto& key = columns_[primary_key_];
+        if (primary_index_.size() + count > primary_index_.bucket_count() * primary_index_.max_load_factor())
+            primary_index_.reserve(primary_index_.size() + count);
+        for (size_t i = first; i < size_; ++i) {
+            primary_index_.emplace(key.Key(i), i);
+        }
+    }
+    for (auto& index : indexes_) {
+        auto& column = columns_[index.second.column()];
+        for (size_t i = first; i < size_; ++i) {
+            if (!column.IsNull(i))
+                index.second.Insert(column.Key(i), i);
         }
     }
 
-    return new_table;
+    return true;
 }
 
-Table* MyAwesomeDB::RightJoin(const std::string& table_l, const std::string& table_r, const std::vector<std::vector<Condition>>& join_on) {
-    return LeftJoin(table_r, table_l, join_on);
+std::string Table::Get(int index, const std::string& name) {
+    if (IsColumnName(name))
+        return columns_[name].ToString(index);
+    else
+        return name;
 }
 
-std::vector<std::string> MyAwesomeDB::SelectAllJoined(const std::string& table_l, const std::string& table_r,
-                                         const std::string& join_type, const std::vector<std::vector<Condition>>& join_on,
-                                         const std::vector<std::string>& columns) {
-    if (tables_.find(table_l) == tables_.end())
-        return {"-- NO TABLE " + table_l + " FOUND --\n"};
-    if (tables_.find(table_r) == tables_.end())
-        return {"-- NO TABLE " + table_r + " FOUND --\n"};
-    Table* joined;
-    if (join_type == "INNER") {
-        joined = InnerJoin(table_l, table_r, join_on);
-    } else if (join_type == "LEFT") {
-        joined = LeftJoin(table_l, table_r, join_on);
-    } else if (join_type == "RIGHT") {
-        joined = RightJoin(table_l, table_r, join_on);
-    }
-    std::string name = table_l+"join"+table_r;
-    tables_.insert({name, joined});
-    std::vector<bool> empty;
-    std::vector<std::string> result = MakeOutput(name, columns, empty, true);
-    tables_.erase(name);
-    delete joined;
+Types Table::GetType(const std::string& name) {
+    return columns_[name].type();
+}
 
-    return result;
+bool Table::IsColumnName(const std::string& value) {
+    return columns_.find(value) != columns_.end();
 }
 
-std::vector<std::string> MyAwesomeDB::SelectJoined(const std::string& table_l, const std::string& table_r,
-                                      const std::string& join_type, const std::vector<std::vector<Condition>>& join_on,
-                                      const std::vector<std::string>& columns,
-                                      const std::vector<std::vector<Condition>>& conditions) {
-    if (tables_.find(table_l) == tables_.end())
-        return {"-- NO TABLE " + table_l + " FOUND --\n"};
-    if (tables_.find(table_r) == tables_.end())
-        return {"-- NO TABLE " + table_r + " FOUND --\n"};
-    Table* joined;
-    if (join_type == "INNER") {
-        joined = InnerJoin(table_l, table_r, join_on);
-    } else if (join_type == "LEFT") {
-        joined = LeftJoin(table_l, table_r, join_on);
-    } else if (join_type == "RIGHT") {
-        joined = RightJoin(table_l, table_r, join_on);
-    }
-    std::string name = table_l+"join"+table_r;
-    tables_.insert({name, joined});
-    auto selected = GetRows(name, conditions);
-    std::vector<std::string> result = MakeOutput(name, columns, selected);
-    tables_.erase(name);
-    delete joined;
+bool Table::IsVisible(size_t row, const ReadView& view) const {
+    return view.Sees(xmin_[row]) && !view.Sees(xmax_[row]);
+}
 
-    return result;
+void Table::MaskVisible(const ReadView& view, size_t begin, size_t end, uint64_t* words) const {
+    uint64_t horizon = view.Horizon();
+    if (dead_ == 0 && newest_ < horizon)
+        return;
+    const uint64_t* xmin = xmin_.data();
+    const uint64_t* xmax = xmax_.data();
+    for (size_t base = begin; base < end; base += 64) {
+        uint64_t& word = words[(base - begin) / 64];
+        if (word == 0)
+            continue;
+        size_t size = std::min<size_t>(64, end - base);
+        uint64_t mask = 0;
+        for (size_t i = 0; i < size; ++i) {
+            mask |= uint64_t(xmin[base + i] < horizon && xmax[base + i] == kNever) << i;
+        }
+        for (uint64_t rest = word & ~mask; rest != 0; rest &= rest - 1) {
+            size_t i = __builtin_ctzll(rest);
+            mask |= uint64_t(IsVisible(base + i, view)) << i;
+        }
+        word &= mask;
+    }
+}
+
+Bitmap Table::Visible(const ReadView& view) const {
+    Bitmap result(size_, true);
+    MaskVisible(view, 0, size_, result.MutableWords());
+
+    return result;
+}
+
+bool Table::Conflicts(const Bitmap& rows, const ReadView& view) const {
+    for (size_t i = rows.Next(0); i < rows.Size(); i = rows.Next(i + 1)) {
+        if (!view.Sees(xmin_[i]) || (xmax_[i] != kNever && xmax_[i] != view.xid))
+            return true;
+    }
+
+    return false;
+}
+
+bool Table::Delete(const Bitmap& selected, const ReadView& view, std::string& message) {
+    size_t counter = 0;
+    uint64_t* xmax = xmax_.MutableData();
+    for (size_t i = selected.Next(0); i < selected.Size(); i = selected.Next(i + 1)) {
+        xmax[i] = view.xid;
+        ++counter;
+    }
+    dead_ += counter;
+    message = "\n-- DELETED " + std::to_string(counter) + " ROWS --\n";
+    return true;
+}
+
+bool Table::Update(const std::vector<std::pair<std::string, std::string>>& values, const Bitmap& selected,
+                   const ReadView& view, std::string& message) {
+    for (auto& pair : values) {
+        if (!IsColumnName(pair.first)) {
+            message = "-- NO COLUMN " + pair.first + " FOUND --\n";
+            return false;
+        }
+        if (!Column::IsValid(columns_[pair.first].type(), pair.second)) {
+            message = "-- INVALID VALUE " + pair.second + " FOR COLUMN " + pair.first + " --\n";
+            return false;
+        }
+    }
+    size_t counter = selected.Count();
+    std::vector<std::string> names;
+    std::vector<std::vector<Column>> batches(1);
+    auto& batch = batches[0];
+    for (auto& column : columns_) {
+        names.emplace_back(column.first);
+        batch.emplace_back(column.second.type(), 0, false);
+        batch.back().Reserve(counter);
+        auto value = std::find_if(values.rbegin(), values.rend(), [&](auto& pair) {
+            return pair.first == column.first;
+        });
+        for (size_t i = selected.Next(0); i < selected.Size(); i = selected.Next(i + 1)) {
+            if (value == values.rend()) {
+                batch.back().AppendFrom(column.second, i);
+            } else if (!batch.back().Parse(value->second)) {
+                message = "-- INVALID VALUE " + value->second + " FOR COLUMN " + column.first + " --\n";
+                return false;
+            }
+        }
+    }
+    uint64_t* xmax = xmax_.MutableData();
+    for (size_t i = selected.Next(0); i < selected.Size(); i = selected.Next(i + 1)) {
+        xmax[i] = view.xid;
+    }
+    if (!Append(names, batches, view, message)) {
+        xmax = xmax_.MutableData();
+        for (size_t i = selected.Next(0); i < selected.Size(); i = selected.Next(i + 1)) {
+            xmax[i] = kNever;
+        }
+        return false;
+    }
+    dead_ += counter;
+    message = "\n-- UPDATED " + std::to_string(counter) + " ROWS --\n";
+    return true;
+}
+
+void Table::Rollback(uint64_t xid) {
+    uint64_t* xmin = xmin_.MutableData();
+    uint64_t* xmax = xmax_.MutableData();
+    for (size_t i = 0; i < size_; ++i) {
+        if (xmin[i] == xid) {
+            xmin[i] = kNever;
+            ++dead_;
+        }
+        if (xmax[i] == xid) {
+            xmax[i] = kNever;
+            --dead_;
+        }
+    }
+}
+
+bool Table::Collectable(uint64_t horizon) const {
+    return horizon > horizon_ && dead_ >= kCompactionMinRows && dead_ * 2 >= size_;
+}
+
+size_t Table::Compact(uint64_t horizon) {
+    horizon_ = horizon;
+    Bitmap garbage(size_);
+    size_t counter = 0;
+    for (size_t i = 0; i < size_; ++i) {
+        if (xmin_[i] == kNever || xmax_[i] < horizon) {
+            garbage.Set(i, true);
+            ++counter;
+        }
+    }
+    if (counter == 0)
+        return 0;
+    for (auto& column : columns_) {
+        column.second.Erase(garbage);
+    }
+    uint64_t* xmin = xmin_.MutableData();
+    uint64_t* xmax = xmax_.MutableData();
+    size_t kept = 0;
+    for (size_t i = 0; i < size_; ++i) {
+        if (garbage.Get(i))
+            continue;
+        xmin[kept] = xmin[i];
+        xmax[kept] = xmax[i];
+        ++kept;
+    }
+    xmin_.resize(kept);
+    xmax_.resize(kept);
+    size_ = kept;
+    dead_ -= counter;
+    RebuildIndexes();
+
+    return counter;
+}
+
+void Table::Save(Snapshot& snapshot) const {
+    Bitmap deleted(size_);
+    for (size_t i = 0; i < size_; ++i) {
+        deleted.Set(i, xmin_[i] == kNever || xmax_[i] != kNever);
+    }
+    auto& catalog = snapshot.catalog();
+    catalog.PutString(primary_key_);
+    catalog.PutNumber(size_);
+    catalog.PutNumber(deleted.Count());
+    deleted.Save(snapshot);
+    catalog.PutNumber(columns_.size());
+    for (auto& column : columns_) {
+        catalog.PutString(column.first);
+        column.second.Save(snapshot);
+    }
+    catalog.PutNumber(indexes_.size());
+    for (auto& index : indexes_) {
+        catalog.PutString(index.first);
+        catalog.PutString(index.second.column());
+    }
+}
+
+bool Table::Load(Snapshot& snapshot) {
+    auto& catalog = snapshot.catalog();
+    uint64_t size;
+    uint64_t dead;
+    uint64_t count;
+    Bitmap deleted;
+    if (!catalog.GetString(primary_key_) || !catalog.GetNumber(size) || !catalog.GetNumber(dead) ||
+        !deleted.Load(snapshot) || deleted.Size() != size || !catalog.GetNumber(count))
+        return false;
+    size_ = size;
+    dead_ = dead;
+    xmin_ = Buffer<uint64_t>(size_, 0);
+    xmax_ = Buffer<uint64_t>(size_, kNever);
+    uint64_t* xmax = xmax_.MutableData();
+    for (size_t i = deleted.Next(0); i < size_; i = deleted.Next(i + 1)) {
+        xmax[i] = 0;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string name;
+        if (!catalog.GetString(name) || !columns_[name].Load(snapshot) || columns_[name].Size() != size_)
+            return false;
+    }
+    if (!primary_key_.empty() && !IsColumnName(primary_key_))
+        return false;
+    if (!catalog.GetNumber(count))
+        return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string name;
+        std::string column;
+        if (!catalog.GetString(name) || !catalog.GetString(column) || !IsColumnName(column))
+            return false;
+        indexes_.insert({name, Index(column)});
+    }
+    RebuildIndexes();
+
+    return true;
+}
+
+Cursor::Cursor(std::shared_ptr<Table> table, const std::vector<std::string>& columns, Bitmap selected,
+               ThreadPool* pool, Metrics* metrics)
+        : table_(std::move(table))
+        , selected_(std::move(selected))
+        , pool_(pool)
+        , metrics_(metrics)
+{
+    std::shared_lock<std::shared_mutex> latch(table_->latch());
+    if (columns.size() == 1 && columns[0] == "*") {
+        for (auto& column : table_->columns()) {
+            names_.emplace_back(column.first);
+            columns_.emplace_back(&column.second);
+        }
+    } else {
+        for (auto& name : columns) {
+            size_t dot = name.find('.');
+            std::string column = dot == std::string::npos ? name : name.substr(dot + 1);
+            if (!table_->IsColumnName(column))
+                continue;
+            names_.emplace_back(column);
+            columns_.emplace_back(&table_->GetColumn(column));
+        }
+    }
+    divider_ = "+";
+    for (auto column : columns_) {
+        widths_.emplace_back(column->width());
+        divider_.append(widths_.back() + 2, '-');
+        divider_ += "+";
+    }
+}
+
+Cursor::Cursor(std::shared_ptr<Table> table, const std::vector<std::string>& columns, std::vector<size_t> order,
+               ThreadPool* pool, Metrics* metrics)
+        : Cursor(std::move(table), columns, Bitmap(), pool, metrics)
+{
+    ordered_ = true;
+    order_ = std::move(order);
+}
+
+void Cursor::Render(size_t row, std::string& line) const {
+    line = "| ";
+    for (size_t i = 0; i < columns_.size(); ++i) {
+        size_t start = line.size();
+        columns_[i]->Render(row, line);
+        line.append(std::max(0, widths_[i] - int(line.size() - start)), ' ');
+        line += " | ";
+    }
+}
+
+bool Cursor::Next(std::string& line) {
+    if (!message_.empty()) {
+        if (stage_++ > 0)
+            return false;
+        line = message_;
+        return true;
+    }
+    if (!table_)
+        return false;
+    if (stage_ == 0 || stage_ == 2) {
+        line = divider_;
+        ++stage_;
+        return true;
+    }
+    if (stage_ == 1) {
+        line = "| ";
+        for (size_t i = 0; i < columns_.size(); ++i) {
+            line += names_[i];
+            line.append(std::max(0, widths_[i] - int(names_[i].size())), ' ');
+            line += " | ";
+        }
+        ++stage_;
+        return true;
+    }
+    if (stage_ == 3) {
+        if (line_ == lines_.size()) {
+            rows_.clear();
+            if (ordered_) {
+                for (; row_ < order_.size() && rows_.size() < kRenderRows; ++row_) {
+                    rows_.emplace_back(order_[row_]);
+                }
+            } else {
+                for (row_ = selected_.Next(row_); row_ < selected_.Size() && rows_.size() < kRenderRows;
+                     row_ = selected_.Next(row_ + 1)) {
+                    rows_.emplace_back(row_);
+                }
+            }
+            lines_.resize(rows_.size());
+            line_ = 0;
+            if (metrics_)
+                metrics_->Count(ROWS_RETURNED, rows_.size());
+            auto body = [this](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    Render(rows_[i], lines_[i]);
+                }
+            };
+            std::shared_lock<std::shared_mutex> latch(table_->latch());
+            if (pool_)
+                pool_->ParallelFor(rows_.size(), kRenderMorsel, body);
+            else
+                body(0, rows_.size());
+        }
+        if (line_ < lines_.size()) {
+            line.swap(lines_[line_++]);
+            return true;
+        }
+        line = divider_ + "\n";
+        ++stage_;
+        return true;
+    }
+
+    return false;
+}
+
+bool Cursor::failed() const {
+    return !message_.empty() && message_[0] != '\n';
+}
+
+Transaction::Transaction() = default;
+
+Transaction::~Transaction() = default;
+
+bool Transaction::open() const {
+    return open_;
+}
+
+Cursor MyAwesomeDB::MakeOutput(std::shared_ptr<Table> table, const std::vector<std::string>& columns,
+                               Bitmap selected, const Ordering& ordering) {
+    if (ordering.keys.empty() && ordering.limit == SIZE_MAX && ordering.offset == 0)
+        return {std::move(table), columns, std::move(selected), pool_.get(), metrics_.get()};
+    std::vector<size_t> rows;
+    if (ordering.keys.empty()) {
+        PROFILE_SCOPE(stage, "limit");
+        size_t count = 0;
+        for (size_t row = selected.Next(0); row < selected.Size() && count < ordering.needed();
+             row = selected.Next(row + 1)) {
+            if (count++ >= ordering.offset)
+                rows.emplace_back(row);
+        }
+        PROFILE(stage.Rows(count, rows.size()));
+    } else {
+        std::shared_lock<std::shared_mutex> latch(table->latch());
+        Sorter sorter(ordering.keys);
+        std::string message;
+        if (!sorter.Resolve(table.get(), message))
+            return Cursor(message);
+        rows = sorter.Run(selected, ordering.needed(), *pool_);
+        rows.erase(rows.begin(), rows.begin() + std::min(ordering.offset, rows.size()));
+    }
+
+    return {std::move(table), columns, std::move(rows), pool_.get(), metrics_.get()};
+}
+
+Types MyAwesomeDB::SeeType(const std::string& str) {
+    if (str == "INT")
+        return INT;
+    else if (str == "BOOL")
+        return BOOL;
+    else if (str == "DOUBLE")
+        return DOUBLE;
+    else if (str == "TEXT")
+        return TEXT;
+    return UNKNOWN;
+}
+
+MyAwesomeDB::MyAwesomeDB()
+        : pool_(std::make_unique<ThreadPool>(std::thread::hardware_concurrency()))
+        , metrics_(std::make_unique<Metrics>())
+{
+    collector_ = std::thread([this] {
+        std::unique_lock<std::mutex> lock(state_);
+        while (!collect_.wait_for(lock, kCollectInterval, [this] { return stopping_; })) {
+            lock.unlock();
+            Collect();
+            lock.lock();
+        }
+    });
+}
+
+void MyAwesomeDB::SetParallelism(size_t threads) {
+    pool_ = std::make_unique<ThreadPool>(threads);
+}
+
+size_t MyAwesomeDB::parallelism() const {
+    return pool_->size();
+}
+
+Metrics& MyAwesomeDB::metrics() {
+    return *metrics_;
+}
+
+std::vector<MetricSample> MyAwesomeDB::Stats() {
+    std::vector<MetricSample> samples = metrics_->Collect();
+    // Count the rows a new statement would see, not every stored version.
+    ReadView view = MakeView(uint64_t(0));
+    std::shared_lock<std::shared_mutex> catalog(catalog_);
+    samples.push_back({"db_tables", "", "gauge", double(tables_.size())});
+    std::vector<MetricSample> memory;
+    for (auto& [name, table] : tables_) {
+        std::shared_lock<std::shared_mutex> latch(table->latch());
+        size_t bytes = 0;
+        for (auto& column : table->columns()) {
+            bytes += column.second.MemoryUsage();
+        }
+        samples.push_back({"db_table_rows", "table=\"" + name + "\"", "gauge", double(table->Visible(view).Count())});
+        memory.push_back({"db_table_memory_bytes", "table=\"" + name + "\"", "gauge", double(bytes)});
+    }
+    samples.insert(samples.end(), memory.begin(), memory.end());
+
+    return samples;
+}
+
+MyAwesomeDB::~MyAwesomeDB() {
+    {
+        std::lock_guard<std::mutex> lock(state_);
+        stopping_ = true;
+    }
+    collect_.notify_all();
+    collector_.join();
+    log_.reset();
+}
+
+bool MyAwesomeDB::Log(const LogRecord& record, std::string& message) {
+    if (!log_ || log_->Commit(log_->Append(record)))
+        return true;
+    message += "-- WRITE-AHEAD LOG FAILURE --\n";
+
+    return false;
+}
+
+bool MyAwesomeDB::Log(const std::vector<LogRecord>& records, std::string& message) {
+    if (!log_ || records.empty())
+        return true;
+    PROFILE_SCOPE(stage, "log");
+    PROFILE(stage.Rows(records.size(), records.size()));
+    uint64_t lsn = 0;
+    for (auto& record : records) {
+        lsn = log_->Append(record);
+    }
+    if (log_->Commit(lsn))
+        return true;
+    message += "-- WRITE-AHEAD LOG FAILURE --\n";
+
+    return false;
+}
+
+std::shared_ptr<Table> MyAwesomeDB::Find(const std::string& name) const {
+    std::shared_lock<std::shared_mutex> catalog(catalog_);
+    auto table = tables_.find(name);
+
+    return table == tables_.end() ? nullptr : table->second;
+}
+
+std::shared_ptr<Table> MyAwesomeDB::Pin(std::shared_ptr<Table> table) {
+    if (!table)
+        return nullptr;
+    table->Pin();
+    Table* pinned = table.get();
+
+    return std::shared_ptr<Table>(pinned, [table](Table* unpinned) { unpinned->Unpin(); });
+}
+
+ReadView MyAwesomeDB::MakeView(uint64_t xid) {
+    std::lock_guard<std::mutex> lock(state_);
+
+    return {xid, next_xid_, active_};
+}
+
+ReadView MyAwesomeDB::MakeView(Transaction* transaction) {
+    if (transaction != nullptr && transaction->open_)
+        return transaction->view_;
+
+    return MakeView(uint64_t(0));
+}
+
+bool MyAwesomeDB::LockWriter(std::unique_lock<std::timed_mutex>& writer, std::string& message) {
+    writer = std::unique_lock<std::timed_mutex>(writer_, kWriterTimeout);
+    if (!writer.owns_lock())
+        message = "-- LOCK TIMEOUT: ANOTHER TRANSACTION IS WRITING --\n";
+
+    return writer.owns_lock();
+}
+
+bool MyAwesomeDB::StartWrite(Transaction& transaction, std::string& message) {
+    if (transaction.writer_.owns_lock())
+        return true;
+    if (!LockWriter(transaction.writer_, message))
+        return false;
+    std::lock_guard<std::mutex> lock(state_);
+    transaction.xid_ = next_xid_++;
+    if (transaction.open_) {
+        transaction.view_.xid = transaction.xid_;
+    } else {
+        // Writers are serialized by the log, so a write may build on a commit still waiting for its flush: if
+        // that flush fails, every later record fails with it.
+        transaction.view_ = {transaction.xid_, next_xid_, {}};
+        std::set_difference(active_.begin(), active_.end(), committing_.begin(), committing_.end(),
+                            std::back_inserter(transaction.view_.active));
+    }
+    active_.push_back(transaction.xid_);
+
+    return true;
+}
+
+void MyAwesomeDB::Touch(Transaction& transaction, const std::shared_ptr<Table>& table) {
+    if (std::find(transaction.tables_.begin(), transaction.tables_.end(), table) == transaction.tables_.end())
+        transaction.tables_.push_back(table);
+}
+
+bool MyAwesomeDB::Finish(Transaction& transaction, bool commit, std::string& message) {
+    auto& records = transaction.records_;
+    uint64_t lsn = 0;
+    if (commit && log_ && records.size() == 1) {
+        lsn = log_->Append(records[0]);
+    } else if (commit && log_ && records.size() > 1) {
+        LogRecord record(LOG_TRANSACTION);
+        record.PutNumber(records.size());
+        for (auto& child : records) {
+            record.PutNumber(child.type());
+            record.PutString(child.payload());
+        }
+        lsn = log_->Append(record);
+    }
+    if (lsn != 0) {
+        // Wait for the flush without the writer lock so the next writers can append to the same batch; the
+        // versions stay invisible to readers until it is durable.
+        {
+            std::lock_guard<std::mutex> lock(state_);
+            committing_.push_back(transaction.xid_);
+        }
+        if (transaction.writer_.owns_lock())
+            transaction.writer_.unlock();
+        if (!log_->Commit(lsn)) {
+            message = "-- WRITE-AHEAD LOG FAILURE --\n";
+            commit = false;
+        }
+    }
+    if (!commit) {
+        for (auto& table : transaction.tables_) {
+            std::unique_lock<std::shared_mutex> latch(table->latch());
+            table->Rollback(transaction.xid_);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(state_);
+        if (transaction.xid_ != 0)
+            active_.erase(std::find(active_.begin(), active_.end(), transaction.xid_));
+        if (lsn != 0)
+            committing_.erase(std::find(committing_.begin(), committing_.end(), transaction.xid_));
+        if (transaction.open_)
+            horizons_.erase(horizons_.find(transaction.view_.Horizon()));
+    }
+    if (lsn != 0)
+        committed_.notify_all();
+    transaction.open_ = false;
+    transaction.xid_ = 0;
+    transaction.view_ = ReadView();
+    records.clear();
+    transaction.tables_.clear();
+    if (transaction.writer_.owns_lock())
+        transaction.writer_.unlock();
+
+    return commit;
+}
+
+uint64_t MyAwesomeDB::Horizon() {
+    std::lock_guard<std::mutex> lock(state_);
+    uint64_t horizon = next_xid_;
+    if (!active_.empty())
+        horizon = std::min(horizon, active_.front());
+    if (!horizons_.empty())
+        horizon = std::min(horizon, *horizons_.begin());
+
+    return horizon;
+}
+
+void MyAwesomeDB::Collect() {
+    std::unique_lock<std::timed_mutex> writer(writer_, std::try_to_lock);
+    if (!writer.owns_lock())
+        return;
+    uint64_t horizon = Horizon();
+    std::shared_lock<std::shared_mutex> catalog(catalog_);
+    for (auto& table : tables_) {
+        if (!table.second->Collectable(horizon))
+            continue;
+        std::unique_lock<std::shared_mutex> latch(table.second->latch());
+        if (!table.second->pinned())
+            table.second->Compact(horizon);
+    }
+}
+
+std::string MyAwesomeDB::Begin(Transaction& transaction) {
+    if (transaction.open_)
+        return "-- TRANSACTION ALREADY STARTED --\n";
+    std::lock_guard<std::mutex> lock(state_);
+    transaction.view_ = {0, next_xid_, active_};
+    horizons_.insert(transaction.view_.Horizon());
+    transaction.open_ = true;
+
+    return "\n-- TRANSACTION STARTED --\n";
+}
+
+std::string MyAwesomeDB::Commit(Transaction& transaction) {
+    if (!transaction.open_)
+        return "-- NO TRANSACTION STARTED --\n";
+    std::string message;
+    if (!Finish(transaction, true, message))
+        return message + "-- TRANSACTION ROLLED BACK --\n";
+
+    return "\n-- TRANSACTION COMMITTED --\n";
+}
+
+std::string MyAwesomeDB::Rollback(Transaction& transaction) {
+    if (!transaction.open_)
+        return "-- NO TRANSACTION STARTED --\n";
+    std::string message;
+    Finish(transaction, false, message);
+
+    return "\n-- TRANSACTION ROLLED BACK --\n";
+}
+
+void MyAwesomeDB::Apply(LogRecord& record) {
+    std::string name;
+    std::string table;
+    std::vector<std::string> columns;
+    std::vector<std::pair<std::string, std::string>> pairs;
+    std::vector<std::vector<Condition>> conditions;
+    if (record.type() == LOG_CREATE_TABLE) {
+        if (record.GetString(name) && record.GetPairs(pairs) && record.GetString(table))
+            CreateTable(name, pairs, table);
+    } else if (record.type() == LOG_DROP_TABLE) {
+        if (record.GetString(name))
+            DeleteTable(name);
+    } else if (record.type() == LOG_CREATE_INDEX) {
+        if (record.GetString(name) && record.GetString(table) && record.GetStrings(columns) && columns.size() == 1)
+            CreateIndex(name, table, columns[0]);
+    } else if (record.type() == LOG_DROP_INDEX) {
+        if (record.GetString(name))
+            DropIndex(name);
+    } else if (record.type() == LOG_INSERT) {
+        uint64_t count;
+        if (!record.GetString(table) || !record.GetStrings(columns) || !record.GetNumber(count))
+            return;
+        std::vector<std::vector<std::string>> rows(count);
+        for (auto& row : rows) {
+            if (!record.GetStrings(row))
+                return;
+        }
+        Insert(table, columns, rows);
+    } else if (record.type() == LOG_DELETE) {
+        if (record.GetString(table) && record.GetConditions(conditions))
+            Delete(table, conditions);
+    } else if (record.type() == LOG_UPDATE) {
+        if (record.GetString(table) && record.GetPairs(pairs) && record.GetConditions(conditions))
+            Update(table, pairs, conditions);
+    } else if (record.type() == LOG_COPY) {
+        std::string delimiter;
+        std::string chunk;
+        std::string message;
+        if (!record.GetString(table) || !record.GetStrings(columns) || !record.GetString(delimiter) ||
+            delimiter.size() != 1 || !record.GetString(chunk))
+            return;
+        auto found = Find(table);
+        if (!found)
+            return;
+        Transaction transaction;
+        if (!StartWrite(transaction, message))
+            return;
+        bool done = Ingest(found.get(), columns, delimiter[0], {chunk}, 0, transaction.view_, message);
+        if (done)
+            Touch(transaction, found);
+        Finish(transaction, done, message);
+    } else if (record.type() == LOG_TRANSACTION) {
+        uint64_t count;
+        uint64_t type;
+        std::string payload;
+        if (!record.GetNumber(count))
+            return;
+        for (uint64_t i = 0; i < count; ++i) {
+            if (!record.GetNumber(type) || !record.GetString(payload))
+                return;
+            LogRecord child(static_cast<RecordType>(type), std::move(payload));
+            Apply(child);
+        }
+    }
+}
+
+bool MyAwesomeDB::Load(Snapshot& snapshot) {
+    uint64_t count;
+    if (!snapshot.catalog().GetNumber(count))
+        return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string name;
+        auto table = std::make_shared<Table>();
+        if (!snapshot.catalog().GetString(name) || tables_.find(name) != tables_.end() || !table->Load(snapshot))
+            return false;
+        tables_.insert({name, table});
+    }
+
+    return true;
+}
+
+bool MyAwesomeDB::Open(const std::string& path, Durability durability, std::string& message) {
+    std::string snapshot_path = path + ".snapshot";
+    uint64_t generation = 0;
+    if (access(snapshot_path.c_str(), F_OK) == 0) {
+        Snapshot snapshot;
+        if (!snapshot.Open(snapshot_path, generation) || !Load(snapshot)) {
+            message = "-- CANNOT LOAD SNAPSHOT " + snapshot_path + " --\n";
+            return false;
+        }
+    }
+    auto log = std::make_unique<WriteAheadLog>();
+    std::vector<LogRecord> records;
+    if (!log->Open(path, durability, records)) {
+        message = "-- CANNOT OPEN LOG " + path + " --\n";
+        return false;
+    }
+    uint64_t logged = 0;
+    size_t first = 0;
+    if (!records.empty() && records[0].type() == LOG_CHECKPOINT && records[0].GetNumber(logged))
+        first = 1;
+    if (logged > generation) {
+        message = "-- SNAPSHOT " + snapshot_path + " IS MISSING OR STALE --\n";
+        return false;
+    }
+    if (logged < generation) {
+        LogRecord record(LOG_CHECKPOINT);
+        record.PutNumber(generation);
+        if (!log->Reset(record)) {
+            message = "-- CANNOT OPEN LOG " + path + " --\n";
+            return false;
+        }
+        first = records.size();
+    }
+    log_.reset();
+    for (size_t i = first; i < records.size(); ++i) {
+        Apply(records[i]);
+    }
+    log_ = std::move(log);
+    path_ = path;
+    generation_ = generation;
+    message = "-- RECOVERED " + std::to_string(tables_.size()) + " TABLES AND " + std::to_string(records.size() - first) +
+              " RECORDS FROM " + path + " --\n";
+
+    return true;
+}
+
+std::string MyAwesomeDB::Checkpoint() {
+    if (!log_)
+        return "-- NO LOG OPENED --\n";
+    std::unique_lock<std::timed_mutex> writer;
+    std::string message;
+    if (!LockWriter(writer, message))
+        return message;
+    {
+        // The snapshot stores every stamped version as committed, so let pending commits settle first.
+        std::unique_lock<std::mutex> lock(state_);
+        committed_.wait(lock, [this] { return committing_.empty(); });
+    }
+    std::shared_lock<std::shared_mutex> catalog(catalog_);
+    std::string path = path_ + ".snapshot";
+    Snapshot snapshot;
+    if (!snapshot.Create(path))
+        return "-- CANNOT WRITE SNAPSHOT " + path + " --\n";
+    snapshot.catalog().PutNumber(tables_.size());
+    for (auto& table : tables_) {
+        snapshot.catalog().PutString(table.first);
+        std::shared_lock<std::shared_mutex> latch(table.second->latch());
+        table.second->Save(snapshot);
+    }
+    LogRecord record(LOG_CHECKPOINT);
+    record.PutNumber(generation_ + 1);
+    if (!snapshot.Commit(generation_ + 1) || !log_->Reset(record))
+        return "-- CANNOT WRITE SNAPSHOT " + path + " --\n";
+    ++generation_;
+
+    return "\n-- CHECKPOINT " + std::to_string(generation_) + " WRITTEN --\n";
+}
+
+std::string MyAwesomeDB::CreateTable(const std::string& name,
+                                     const std::vector<std::pair<std::string, std::string>>& columns,
+                                     const std::string& primary_key) {
+    std::unique_lock<std::timed_mutex> writer;
+    std::string message;
+    if (!LockWriter(writer, message))
+        return message;
+    std::unique_lock<std::shared_mutex> catalog(catalog_);
+    if (tables_.find(name) != tables_.end())
+        return "-- TABLE " + name + " ALREADY EXISTS --\n";
+    std::map<std::string, Column> columns_;
+    Types type;
+    for (auto& column : columns) {
+        type = SeeType(column.second);
+        columns_.insert({column.first, Column(type, column.first.size())});
+    }
+    if (!primary_key.empty() && columns_.find(primary_key) == columns_.end())
+        return "-- NO COLUMN " + primary_key + " FOUND --\n";
+    LogRecord record(LOG_CREATE_TABLE);
+    record.PutString(name);
+    record.PutPairs(columns);
+    record.PutString(primary_key);
+    if (!Log(record, message))
+        return message;
+    tables_.insert({name, std::make_shared<Table>(columns_, primary_key)});
+
+    return "\n-- TABLE " + name + " CREATED --\n";
+}
+
+std::string MyAwesomeDB::CreateIndex(const std::string& name, const std::string& table, const std::string& column) {
+    std::unique_lock<std::timed_mutex> writer;
+    std::string message;
+    if (!LockWriter(writer, message))
+        return message;
+    std::shared_lock<std::shared_mutex> catalog(catalog_);
+    auto found = tables_.find(table);
+    if (found == tables_.end())
+        return "-- NO TABLE " + table + " FOUND --\n";
+    if (!found->second->IsColumnName(column))
+        return "-- NO COLUMN " + column + " FOUND --\n";
+    for (auto& elem : tables_) {
+        if (elem.second->HasIndex(name))
+            return "-- INDEX " + name + " ALREADY EXISTS --\n";
+    }
+    LogRecord record(LOG_CREATE_INDEX);
+    record.PutString(name);
+    record.PutString(table);
+    record.PutStrings({column});
+    if (!Log(record, message))
+        return message;
+    {
+        std::unique_lock<std::shared_mutex> latch(found->second->latch());
+        found->second->CreateIndex(name, column);
+    }
+
+    return "\n-- INDEX " + name + " CREATED --\n";
+}
+
+std::string MyAwesomeDB::DropIndex(const std::string& name) {
+    std::unique_lock<std::timed_mutex> writer;
+    std::string message;
+    if (!LockWriter(writer, message))
+        return message;
+    std::shared_lock<std::shared_mutex> catalog(catalog_);
+    for (auto& elem : tables_) {
+        if (elem.second->HasIndex(name)) {
+            LogRecord record(LOG_DROP_INDEX);
+            record.PutString(name);
+            if (!Log(record, message))
+                return message;
+            std::unique_lock<std::shared_mutex> latch(elem.second->latch());
+            elem.second->DropIndex(name);
+            return "\n-- INDEX " + name + " DELETED --\n";
+        }
+    }
+
+    return "-- NO INDEX " + name + " FOUND --\n";
+}
+
+std::string MyAwesomeDB::DeleteTable(const std::string& name) {
+    std::unique_lock<std::timed_mutex> writer;
+    std::string message;
+    if (!LockWriter(writer, message))
+        return message;
+    std::unique_lock<std::shared_mutex> catalog(catalog_);
+    message = "\n-- TABLE " + name + " DELETED --\n";
+    auto table = tables_.find(name);
+    if (table == tables_.end())
+        return message;
+    LogRecord record(LOG_DROP_TABLE);
+    record.PutString(name);
+    std::string error;
+    if (!Log(record, error))
+        return error;
+    tables_.erase(table);
+
+    return message;
+}
+
+Cursor MyAwesomeDB::SelectAll(const std::string& table, const std::vector<std::string>& columns,
+                              const Ordering& ordering, Transaction* transaction) {
+    auto found = Pin(Find(table));
+    if (!found)
+        return Cursor("-- NO TABLE " + table + " FOUND --\n");
+    ReadView view = MakeView(transaction);
+    if (ordering.keys.empty() && ordering.limit != SIZE_MAX)
+        return MakeOutput(found, columns, GetRows(found.get(), table, {{}}, view, ordering.needed()), ordering);
+    Bitmap selected;
+    {
+        std::shared_lock<std::shared_mutex> latch(found->latch());
+        selected = found->Visible(view);
+    }
+    metrics_->Count(ROWS_SCANNED, selected.Size());
+
+    return MakeOutput(found, columns, std::move(selected), ordering);
+}
+
+Bitmap MyAwesomeDB::GetRows(const std::string& table, const std::vector<std::vector<Condition>>& conditions,
+                            Transaction* transaction) {
+    auto found = Pin(Find(table));
+    if (!found)
+        return Bitmap();
+
+    return GetRows(found.get(), table, conditions, MakeView(transaction));
+}
+
+bool MyAwesomeDB::ExplainScan(const std::string& table, const std::vector<std::vector<Condition>>& conditions,
+                              std::string& plan) {
+    auto found = Pin(Find(table));
+    if (!found)
+        return false;
+    std::shared_lock<std::shared_mutex> latch(found->latch());
+    std::string access = found->AccessPath(Predicate(conditions, {{table, found.get()}}));
+    plan = access.empty() ? table + " sequential, " + KernelName() + " kernels" : table + " using " + access;
+
+    return true;
+}
+
+bool MyAwesomeDB::ExplainJoin(const std::string& table_l, const std::string& table_r,
+                              const std::vector<std::vector<Condition>>& join_on, std::string& plan) {
+    auto lhs = Pin(Find(table_l));
+    auto rhs = Pin(Find(table_r));
+    if (!lhs || !rhs)
+        return false;
+    Table* first = std::min(lhs.get(), rhs.get());
+    Table* second = std::max(lhs.get(), rhs.get());
+    std::shared_lock<std::shared_mutex> first_latch(first->latch());
+    std::shared_lock<std::shared_mutex> second_latch;
+    if (second != first)
+        second_latch = std::shared_lock<std::shared_mutex>(second->latch());
+    Predicate predicate(join_on, {{table_l, lhs.get()}, {table_r, rhs.get()}});
+    const Column* lhs_key;
+    const Column* rhs_key;
+    if (!predicate.EquiJoinKey(lhs_key, rhs_key))
+        plan = "nested loop";
+    else
+        plan = "hash, build " + (lhs->Size() < rhs->Size() ? table_l : table_r) +
+               ((lhs->Size() < rhs->Size() ? lhs_key : rhs_key)->encoded() ? " on dictionary codes" : "");
+
+    return true;
+}
+
+Bitmap MyAwesomeDB::GetRows(Table* table, const std::string& name,
+                            const std::vector<std::vector<Condition>>& conditions, const ReadView& view,
+                            size_t needed) {
+    std::shared_lock<std::shared_mutex> latch(table->latch());
+    PROFILE_SCOPE(stage, "scan");
+    Bitmap result(table->Size());
+    Predicate predicate(conditions, {{name, table}});
+    std::vector<size_t> candidates;
+    if (table->Lookup(predicate, candidates)) {
+        for (auto row : candidates) {
+            result.Set(row, table->IsVisible(row, view) && predicate.Evaluate(row));
+        }
+        PROFILE(if (stage.active()) {
+            stage.Detail(name + " using " + table->AccessPath(predicate));
+            stage.Rows(candidates.size(), result.Count());
+            stage.Evaluations(candidates.size());
+        });
+        metrics_->Count(ROWS_SCANNED, candidates.size());
+        return result;
+    }
+    uint64_t* words = result.MutableWords();
+    PROFILE(std::atomic<size_t> evaluations(0));
+    auto filter = [&](size_t begin, size_t end) {
+        [[maybe_unused]] size_t compared = predicate.Filter(begin, end, words + begin / 64);
+        PROFILE(evaluations += compared);
+        table->MaskVisible(view, begin, end, words + begin / 64);
+    };
+    size_t scanned = result.Size();
+    if (needed == SIZE_MAX) {
+        pool_->ParallelFor(result.Size(), kMorselRows, filter);
+    } else {
+        size_t wave = kMorselRows * pool_->size();
+        size_t found = 0;
+        for (scanned = 0; scanned < result.Size() && found < needed; scanned += wave) {
+            size_t end = std::min(result.Size(), scanned + wave);
+            pool_->ParallelFor(end - scanned, kMorselRows, [&](size_t first, size_t last) {
+                filter(scanned + first, scanned + last);
+            });
+            for (size_t i = scanned / 64; i < (end + 63) / 64; ++i) {
+                found += __builtin_popcountll(words[i]);
+            }
+        }
+        scanned = std::min(scanned, result.Size());
+    }
+    metrics_->Count(ROWS_SCANNED, scanned);
+    PROFILE(if (stage.active()) {
+        stage.Detail(name + " sequential, " + KernelName() + " kernels");
+        stage.Rows(scanned, result.Count());
+        stage.Evaluations(evaluations);
+    });
+
+    return result;
+}
+
+Cursor MyAwesomeDB::Select(const std::string& table, const std::vector<std::string>& columns,
+                           const std::vector<std::vector<Condition>>& conditions, const Ordering& ordering,
+                           Transaction* transaction) {
+    auto found = Pin(Find(table));
+    if (!found)
+        return Cursor("-- NO TABLE " + table + " FOUND --\n");
+    size_t needed = ordering.keys.empty() ? ordering.needed() : SIZE_MAX;
+    auto selected = GetRows(found.get(), table, conditions, MakeView(transaction), needed);
+
+    return MakeOutput(found, columns, std::move(selected), ordering);
+}
+
+std::string MyAwesomeDB::Insert(const std::string& table, const std::vector<std::string>& columns,
+                                const std::vector<std::vector<std::string>>& values, Transaction* transaction) {
+    Transaction local;
+    Transaction& active = transaction != nullptr && transaction->open_ ? *transaction : local;
+    std::string message;
+    if (!StartWrite(active, message))
+        return message;
+    auto found = Find(table);
+    bool done = found != nullptr;
+    if (!done) {
+        message = "-- NO TABLE " + table + " FOUND --\n";
+    } else {
+        const ReadView& view = active.view_;
+        std::unique_lock<std::shared_mutex> latch(found->latch());
+        PROFILE_SCOPE(stage, "insert");
+        PROFILE(stage.Detail(table));
+        done = found->Insert(columns, values, view, message);
+        PROFILE(stage.Rows(values.size(), done ? values.size() : 0));
+    }
+    if (done) {
+        Touch(active, found);
+        if (log_) {
+            LogRecord record(LOG_INSERT);
+            record.PutString(table);
+            record.PutStrings(columns);
+            record.PutNumber(values.size());
+            for (auto& row : values) {
+                record.PutStrings(row);
+            }
+            active.records_.emplace_back(std::move(record));
+        }
+    }
+    if (&active == &local)
+        Finish(local, done, message);
+
+    return message;
+}
+
+std::string MyAwesomeDB::Delete(const std::string& table, const std::vector<std::vector<Condition>>& conditions,
+                                Transaction* transaction) {
+    Transaction local;
+    Transaction& active = transaction != nullptr && transaction->open_ ? *transaction : local;
+    std::string message;
+    if (!StartWrite(active, message))
+        return message;
+    auto found = Find(table);
+    bool done = found != nullptr;
+    if (!done) {
+        message = "-- NO TABLE " + table + " FOUND --\n";
+    } else {
+        const ReadView& view = active.view_;
+        PROFILE_SCOPE(stage, "delete");
+        PROFILE(stage.Detail(table));
+        auto selected = GetRows(found.get(), table, conditions, view);
+        // Inside a transaction the latest versions can differ from its snapshot; matching rows written since BEGIN
+        // are conflicts too.
+        Bitmap latest = active.open_ ? GetRows(found.get(), table, conditions, MakeView(active.xid_)) : Bitmap();
+        std::unique_lock<std::shared_mutex> latch(found->latch());
+        if (found->Conflicts(selected, view) || found->Conflicts(latest, view)) {
+            message = "-- SERIALIZATION FAILURE: ROW CHANGED BY A CONCURRENT TRANSACTION --\n";
+            done = false;
+        } else {
+            done = found->Delete(selected, view, message);
+        }
+        PROFILE(if (stage.active()) stage.Rows(selected.Count(), done ? selected.Count() : 0));
+    }
+    if (done) {
+        Touch(active, found);
+        if (log_) {
+            LogRecord record(LOG_DELETE);
+            record.PutString(table);
+            record.PutConditions(conditions);
+            active.records_.emplace_back(std::move(record));
+        }
+    }
+    if (&active == &local)
+        Finish(local, done, message);
+
+    return message;
+}
+
+std::string MyAwesomeDB::Vacuum(const std::string& table) {
+    std::unique_lock<std::timed_mutex> writer;
+    std::string message;
+    if (!LockWriter(writer, message))
+        return message;
+    auto found = Find(table);
+    if (!found)
+        return "-- NO TABLE " + table + " FOUND --\n";
+    uint64_t horizon = Horizon();
+    std::unique_lock<std::shared_mutex> latch(found->latch());
+    size_t counter = found->pinned() ? 0 : found->Compact(horizon);
+
+    return "\n-- VACUUMED " + std::to_string(counter) + " ROWS --\n";
+}
+
+bool MyAwesomeDB::Ingest(Table* table, const std::vector<std::string>& columns, char delimiter,
+                         const std::vector<std::string_view>& chunks, size_t first_line, const ReadView& view,
+                         std::string& message) {
+    std::vector<Types> types;
+    for (auto& column : columns) {
+        types.emplace_back(table->GetType(column));
+    }
+    std::vector<std::vector<Column>> batches;
+    Loader loader(columns, types, delimiter);
+    if (!loader.Load(chunks, first_line, *pool_, batches, message))
+        return false;
+    {
+        std::unique_lock<std::shared_mutex> latch(table->latch());
+        if (!table->Append(columns, batches, view, message))
+            return false;
+    }
+    size_t count = 0;
+    for (auto& batch : batches) {
+        count += batch[0].Size();
+    }
+    message = "\n-- COPIED " + std::to_string(count) + " ROWS --\n";
+
+    return true;
+}
+
+std::string MyAwesomeDB::Copy(const std::string& table, std::vector<std::string> columns, const std::string& path,
+                              char delimiter, bool header, Transaction* transaction) {
+    auto found = Find(table);
+    if (!found)
+        return "-- NO TABLE " + table + " FOUND --\n";
+    if (columns.empty()) {
+        for (auto& column : found->columns()) {
+            columns.emplace_back(column.first);
+        }
+    }
+    for (auto& column : columns) {
+        if (!found->IsColumnName(column))
+            return "-- NO COLUMN " + column + " FOUND --\n";
+    }
+    std::shared_ptr<const char> mapping;
+    size_t size;
+    if (!Loader::Map(path, mapping, size))
+        return "-- CANNOT READ FILE " + path + " --\n";
+    std::string_view data(mapping.get(), size);
+    size_t first_line = 0;
+    if (header) {
+        size_t end = data.find('\n');
+        data.remove_prefix(end == std::string_view::npos ? data.size() : end + 1);
+        first_line = 1;
+    }
+    std::vector<std::string_view> chunks;
+    Loader::Split(data, pool_->size(), chunks);
+    Transaction local;
+    Transaction& active = transaction != nullptr && transaction->open_ ? *transaction : local;
+    std::string message;
+    if (!StartWrite(active, message))
+        return message;
+    bool done = Ingest(found.get(), columns, delimiter, chunks, first_line, active.view_, message);
+    if (done) {
+        Touch(active, found);
+        for (size_t i = 0; log_ && i < chunks.size(); ++i) {
+            LogRecord record(LOG_COPY);
+            record.PutString(table);
+            record.PutStrings(columns);
+            record.PutString(std::string(1, delimiter));
+            record.PutString(std::string(chunks[i]));
+            active.records_.emplace_back(std::move(record));
+        }
+    }
+    if (&active == &local)
+        Finish(local, done, message);
+
+    return message;
+}
+
+std::string MyAwesomeDB::Update(const std::string& table,
+                                const std::vector<std::pair<std::string, std::string>>& values,
+                                const std::vector<std::vector<Condition>>& conditions, Transaction* transaction) {
+    Transaction local;
+    Transaction& active = transaction != nullptr && transaction->open_ ? *transaction : local;
+    std::string message;
+    if (!StartWrite(active, message))
+        return message;
+    auto found = Find(table);
+    bool done = found != nullptr;
+    if (!done) {
+        message = "-- NO TABLE " + table + " FOUND --\n";
+    } else {
+        const ReadView& view = active.view_;
+        PROFILE_SCOPE(stage, "update");
+        PROFILE(stage.Detail(table));
+        auto selected = GetRows(found.get(), table, conditions, view);
+        // Inside a transaction the latest versions can differ from its snapshot; matching rows written since BEGIN
+        // are conflicts too.
+        Bitmap latest = active.open_ ? GetRows(found.get(), table, conditions, MakeView(active.xid_)) : Bitmap();
+        std::unique_lock<std::shared_mutex> latch(found->latch());
+        if (found->Conflicts(selected, view) || found->Conflicts(latest, view)) {
+            message = "-- SERIALIZATION FAILURE: ROW CHANGED BY A CONCURRENT TRANSACTION --\n";
+            done = false;
+        } else {
+            done = found->Update(values, selected, view, message);
+        }
+        PROFILE(if (stage.active()) stage.Rows(selected.Count(), done ? selected.Count() : 0));
+    }
+    if (done) {
+        Touch(active, found);
+        if (log_) {
+            LogRecord record(LOG_UPDATE);
+            record.PutString(table);
+            record.PutPairs(values);
+            record.PutConditions(conditions);
+            active.records_.emplace_back(std::move(record));
+        }
+    }
+    if (&active == &local)
+        Finish(local, done, message);
+
+    return message;
+}
+
+static std::string Unqualified(const std::string& name) {
+    size_t dot = name.find('.');
+
+    return dot == std::string::npos ? name : name.substr(dot + 1);
+}
+
+// The columns a joined result is read through: its output columns and ORDER BY keys.
+static std::vector<std::string> Projected(const std::vector<std::string>& columns, const Ordering& ordering) {
+    if (columns.size() == 1 && columns[0] == "*")
+        return columns;
+    std::vector<std::string> projected;
+    for (auto& column : columns) {
+        projected.emplace_back(Unqualified(column));
+    }
+    for (auto& key : ordering.keys) {
+        projected.emplace_back(Unqualified(key.column));
+    }
+
+    return projected;
+}
+
+// Every column name an operand of conditions could resolve to.
+static std::vector<std::string> Referenced(const std::vector<std::vector<Condition>>& conditions) {
+    std::vector<std::string> referenced;
+    for (auto& conjunction : conditions) {
+        for (auto& condition : conjunction) {
+            for (auto* value : {&condition.lhs(), &condition.rhs()}) {
+                if (!value->empty() && (isalpha(static_cast<unsigned char>((*value)[0])) || (*value)[0] == '_'))
+                    referenced.emplace_back(Unqualified(*value));
+            }
+        }
+    }
+
+    return referenced;
+}
+
+// The joined columns named in columns ("*" for all); text columns keep their dictionary when encoded is set.
+static std::map<std::string, Column> JoinedColumns(Table* lhs, Table* rhs, const std::vector<std::string>& columns,
+                                                   bool encoded) {
+    bool all = columns.size() == 1 && columns[0] == "*";
+    std::map<std::string, Column> joined;
+    for (Table* table : {lhs, rhs}) {
+        for (auto& column : table->columns()) {
+            if (joined.find(column.first) != joined.end() ||
+                (!all && std::find(columns.begin(), columns.end(), column.first) == columns.end()))
+                continue;
+            joined.insert({column.first, Column(column.second.type(), column.second.width(),
+                                                encoded && column.second.encoded())});
+        }
+    }
+
+    return joined;
+}
+
+Table* MyAwesomeDB::Join(const std::shared_ptr<Table>& lhs, const std::string& table_l,
+                         const std::shared_ptr<Table>& rhs, const std::string& table_r, const std::string& join_type,
+                         const std::vector<std::vector<Condition>>& join_on,
+                         const std::vector<std::vector<Condition>>& conditions, const std::vector<std::string>& columns,
+                         size_t needed, Transaction* transaction) {
+    ReadView view = MakeView(transaction);
+    Table* first = std::min(lhs.get(), rhs.get());
+    Table* second = std::max(lhs.get(), rhs.get());
+    std::shared_lock<std::shared_mutex> first_latch(first->latch());
+    std::shared_lock<std::shared_mutex> second_latch;
+    if (second != first)
+        second_latch = std::shared_lock<std::shared_mutex>(second->latch());
+    PROFILE_SCOPE(stage, "join");
+    PROFILE(if (stage.active()) stage.Detail(join_type + " " + table_l + ", " + table_r));
+    // A right join is the left join of the swapped tables.
+    bool right = join_type == "RIGHT";
+    bool left = right || join_type == "LEFT";
+    Table* outer = right ? rhs.get() : lhs.get();
+    Table* inner = right ? lhs.get() : rhs.get();
+    Predicate predicate(join_on, {{right ? table_r : table_l, outer}, {right ? table_l : table_r, inner}});
+    Bitmap outer_rows = outer->Visible(view);
+    Bitmap inner_rows = inner->Visible(view);
+    metrics_->Count(ROWS_SCANNED, outer_rows.Size() + inner_rows.Size());
+    // The hash table lives in this thread's arena until the join is done; the morsels only read it.
+    ArenaScope arena;
+    JoinMatcher matcher(outer, outer_rows, inner, inner_rows, predicate, *pool_);
+
+    std::map<std::string, Column> layout = JoinedColumns(outer, inner, columns, true);
+    // Where each output column is copied from: the inner table when the row has a match there, else the outer one.
+    std::vector<std::pair<const Column*, const Column*>> sources;
+    for (auto& column : layout) {
+        sources.emplace_back(inner->IsColumnName(column.first) ? &inner->GetColumn(column.first) : nullptr,
+                             outer->IsColumnName(column.first) ? &outer->GetColumn(column.first) : nullptr);
+    }
+    std::string name = table_l + "join" + table_r;
+    std::vector<std::string> referenced = Referenced(conditions);
+    struct Chunk {
+        std::vector<Column> columns;
+        size_t rows = 0;
+    };
+    size_t morsel = matcher.morsel();
+    std::vector<Chunk> chunks((outer->Size() + morsel - 1) / morsel);
+    // Each worker claims the next morsel in order and refills its own scratch table for the filter.
+    std::vector<std::unique_ptr<Table>> scratch(std::max<size_t>(1, std::min(pool_->size(), chunks.size())));
+    std::atomic<size_t> next(0);
+    // Rows kept by the longest run of finished morsels from the first; once it holds needed rows, no later morsel
+    // can contribute.
+    std::vector<bool> finished(chunks.size());
+    size_t frontier = 0;
+    std::atomic<size_t> ready(0);
+    std::mutex frontier_mutex;
+    std::atomic<size_t> paired(0);
+    PROFILE(std::atomic<size_t> evaluations(0));
+    {
+        PROFILE_SCOPE(pipeline, "pipeline");
+        pool_->ParallelFor(scratch.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t part = begin; part < end; ++part) {
+                for (size_t index = next++; index < chunks.size() && ready < needed; index = next++) {
+                    size_t start = index * morsel;
+                    ArenaScope morsel_arena;
+                    ArenaVector<std::pair<size_t, size_t>> pairs;
+                    [[maybe_unused]] size_t evaluated =
+                            matcher.Probe(start, std::min(outer->Size(), start + morsel), left, pairs);
+                    ArenaVector<uint64_t> kept((pairs.size() + 63) / 64, ~uint64_t(0));
+                    if (!conditions.empty() && !pairs.empty()) {
+                        auto& table = scratch[part];
+                        if (!table)
+                            table = std::make_unique<Table>(JoinedColumns(outer, inner, referenced, false));
+                        table->Clear();
+                        for (auto& pair : pairs) {
+                            table->AppendJoined(outer, pair.first, inner,
+                                                pair.second == SIZE_MAX ? -1 : int(pair.second));
+                        }
+                        Predicate filter(conditions, {{name, table.get()}});
+                        evaluated += filter.Filter(0, pairs.size(), kept.data());
+                    }
+                    auto& chunk = chunks[index];
+                    for (auto& column : layout) {
+                        chunk.columns.emplace_back(column.second.type(), column.second.width(), false);
+                    }
+                    for (size_t i = 0; i < pairs.size() && chunk.rows < needed; ++i) {
+                        if ((kept[i / 64] >> (i % 64) & 1) == 0)
+                            continue;
+                        for (size_t c = 0; c < sources.size(); ++c) {
+                            if (pairs[i].second != SIZE_MAX && sources[c].first != nullptr)
+                                chunk.columns[c].AppendFrom(*sources[c].first, pairs[i].second);
+                            else if (sources[c].second != nullptr)
+                                chunk.columns[c].AppendFrom(*sources[c].second, pairs[i].first);
+                            else
+                                chunk.columns[c].AppendNull();
+                        }
+                        ++chunk.rows;
+                    }
+                    paired += pairs.size();
+                    PROFILE(evaluations += evaluated);
+                    std::lock_guard<std::mutex> lock(frontier_mutex);
+                    finished[index] = true;
+                    for (; frontier < chunks.size() && finished[frontier]; ++frontier) {
+                        ready += chunks[frontier].rows;
+                    }
+                }
+            }
+        });
+        if (!conditions.empty())
+            metrics_->Count(ROWS_SCANNED, paired);
+        PROFILE(if (pipeline.active()) {
+            std::string detail = matcher.method();
+            if (!conditions.empty())
+                detail += ", filter";
+            std::string names;
+            for (auto& column : layout) {
+                names += (names.empty() ? "" : ", ") + column.first;
+            }
+            if (!names.empty())
+                detail += ", materialize " + names;
+            size_t kept = 0;
+            for (auto& chunk : chunks) {
+                kept += chunk.rows;
+            }
+            pipeline.Detail(detail);
+            pipeline.Rows(paired, kept);
+            pipeline.Evaluations(evaluations);
+        });
+    }
+    PROFILE_SCOPE(concatenate, "concatenate");
+    size_t size = 0;
+    size_t used = 0;
+    for (; used < chunks.size() && size < needed; ++used) {
+        size += chunks[used].rows;
+    }
+    std::vector<Column*> targets;
+    for (auto& column : layout) {
+        targets.push_back(&column.second);
+    }
+    // Each chunk column is freed once copied, so the result and its chunks never both hold every column.
+    pool_->ParallelFor(targets.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            targets[c]->Reserve(size);
+            for (size_t i = 0; i < used; ++i) {
+                if (chunks[i].rows == 0)
+                    continue;
+                targets[c]->AppendColumn(chunks[i].columns[c]);
+                chunks[i].columns[c] = Column(targets[c]->type(), 0, false);
+            }
+        }
+    });
+    PROFILE(concatenate.Rows(size, size));
+    PROFILE(stage.Rows(lhs->Size() + rhs->Size(), size));
+
+    return new Table(std::move(layout), size);
+}
+
+Cursor MyAwesomeDB::SelectAllJoined(const std::string& table_l, const std::string& table_r,
+                                    const std::string& join_type, const std::vector<std::vector<Condition>>& join_on,
+                                    const std::vector<std::string>& columns, const Ordering& ordering,
+                                    Transaction* transaction) {
+    auto lhs = Pin(Find(table_l));
+    if (!lhs)
+        return Cursor("-- NO TABLE " + table_l + " FOUND --\n");
+    auto rhs = Pin(Find(table_r));
+    if (!rhs)
+        return Cursor("-- NO TABLE " + table_r + " FOUND --\n");
+    size_t needed = ordering.keys.empty() ? ordering.needed() : SIZE_MAX;
+    std::shared_ptr<Table> joined(
+            Join(lhs, table_l, rhs, table_r, join_type, join_on, {}, Projected(columns, ordering), needed, transaction));
+    Bitmap selected(joined->Size(), true);
+
+    return MakeOutput(joined, columns, std::move(selected), ordering);
+}
+
+Cursor MyAwesomeDB::SelectJoined(const std::string& table_l, const std::string& table_r,
+                                 const std::string& join_type, const std::vector<std::vector<Condition>>& join_on,
+                                 const std::vector<std::string>& columns,
+                                 const std::vector<std::vector<Condition>>& conditions, const Ordering& ordering,
+                                 Transaction* transaction) {
+    auto lhs = Pin(Find(table_l));
+    if (!lhs)
+        return Cursor("-- NO TABLE " + table_l + " FOUND --\n");
+    auto rhs = Pin(Find(table_r));
+    if (!rhs)
+        return Cursor("-- NO TABLE " + table_r + " FOUND --\n");
+    size_t needed = ordering.keys.empty() ? ordering.needed() : SIZE_MAX;
+    std::shared_ptr<Table> joined(Join(lhs, table_l, rhs, table_r, join_type, join_on, conditions,
+                                       Projected(columns, ordering), needed, transaction));
+    Bitmap selected(joined->Size(), true);
+
+    return MakeOutput(joined, columns, std::move(selected), ordering);
+}
+
+Cursor MyAwesomeDB::Group(Table* table, const std::string& name, const Bitmap& selected,
+                          const std::vector<Aggregate>& aggregates, const std::vector<std::string>& group_by,
+                          const std::vector<std::string>& columns,
+                          const std::vector<std::vector<Condition>>& having, const Ordering& ordering) {
+    Aggregator aggregator(group_by, aggregates);
+    std::string message;
+    std::shared_ptr<Table> grouped;
+    {
+        std::shared_lock<std::shared_mutex> latch(table->latch());
+        if (!aggregator.Resolve(table, message))
+            return Cursor(message);
+        PROFILE_SCOPE(stage, "aggregate");
+        grouped.reset(aggregator.Run(selected, *pool_, message));
+        if (!grouped)
+            return Cursor(message);
+        PROFILE(if (stage.active()) stage.Rows(selected.Count(), grouped->Size()));
+    }
+    if (having.empty())
+        return MakeOutput(grouped, columns, Bitmap(grouped->Size(), true), ordering);
+    Bitmap kept;
+    {
+        PROFILE_SCOPE(stage, "having");
+        kept = GetRows(grouped.get(), name, having, ReadView());
+        PROFILE(if (stage.active()) stage.Rows(grouped->Size(), kept.Count()));
+    }
+
+    return MakeOutput(grouped, columns, std::move(kept), ordering);
+}
+
+Cursor MyAwesomeDB::SelectGrouped(const std::string& table, const std::vector<Aggregate>& aggregates,
+                                  const std::vector<std::string>& group_by, const std::vector<std::string>& columns,
+                                  const std::vector<std::vector<Condition>>& conditions,
+                                  const std::vector<std::vector<Condition>>& having, const Ordering& ordering,
+                                  Transaction* transaction) {
+    auto found = Pin(Find(table));
+    if (!found)
+        return Cursor("-- NO TABLE " + table + " FOUND --\n");
+    ReadView view = MakeView(transaction);
+    Bitmap selected;
+    if (conditions.empty()) {
+        std::shared_lock<std::shared_mutex> latch(found->latch());
+        selected = found->Visible(view);
+        metrics_->Count(ROWS_SCANNED, selected.Size());
+    } else {
+        selected = GetRows(found.get(), table, conditions, view);
+    }
+
+    return Group(found.get(), table, selected, aggregates, group_by, columns, having, ordering);
+}
+
+Cursor MyAwesomeDB::SelectGroupedJoined(const std::string& table_l, const std::string& table_r,
+                                        const std::string& join_type,
+                                        const std::vector<std::vector<Condition>>& join_on,
+                                        const std::vector<Aggregate>& aggregates,
+                                        const std::vector<std::string>& group_by,
+                                        const std::vector<std::string>& columns,
+                                        const std::vector<std::vector<Condition>>& conditions,
+                                        const std::vector<std::vector<Condition>>& having,
+                                        const Ordering& ordering, Transaction* transaction) {
+    auto lhs = Pin(Find(table_l));
+    if (!lhs)
+        return Cursor("-- NO TABLE " + table_l + " FOUND --\n");
+    auto rhs = Pin(Find(table_r));
+    if (!rhs)
+        return Cursor("-- NO TABLE " + table_r + " FOUND --\n");
+    std::vector<std::string> grouped;
+    for (auto& column : group_by) {
+        grouped.emplace_back(Unqualified(column));
+    }
+    for (auto& aggregate : aggregates) {
+        grouped.emplace_back(Unqualified(aggregate.column));
+    }
+    std::unique_ptr<Table> joined(
+            Join(lhs, table_l, rhs, table_r, join_type, join_on, conditions, grouped, SIZE_MAX, transaction));
+
+    return Group(joined.get(), table_l + "join" + table_r, Bitmap(joined->Size(), true), aggregates, group_by,
+                 columns, having, ordering);
 }
@@ -3,8 +3,19 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <set>
+#include <memory>
+#include <unordered_map>
 #include <variant>
-#include <regex>
+#include <string_view>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
 
 namespace DB {
 
@@ -16,17 +27,224 @@ namespace DB {
         UNKNOWN
     };
 
+    class Snapshot;
+
+    class ThreadPool;
+
+    class Metrics;
+
+    struct MetricSample;
+
+    template <typename T>
+    class Buffer {
+    private:
+        std::vector<T> owned_;
+        std::shared_ptr<const char> mapping_;
+        const T* data_ = nullptr;
+        size_t size_ = 0;
+
+        void Sync() {
+            data_ = owned_.data();
+            size_ = owned_.size();
+        }
+
+        void Own() {
+            if (!mapping_)
+                return;
+            owned_.assign(data_, data_ + size_);
+            mapping_.reset();
+            Sync();
+        }
+
+    public:
+        Buffer() = default;
+
+        Buffer(std::initializer_list<T> values)
+                : owned_(values)
+        {
+            Sync();
+        }
+
+        Buffer(size_t size, const T& value)
+                : owned_(size, value)
+        {
+            Sync();
+        }
+
+        explicit Buffer(std::vector<T> values)
+                : owned_(std::move(values))
+        {
+            Sync();
+        }
+
+        Buffer(const Buffer& other)
+                : owned_(other.owned_)
+                , mapping_(other.mapping_)
+                , data_(other.data_)
+                , size_(other.size_)
+        {
+            if (!mapping_)
+                Sync();
+        }
+
+        Buffer(Buffer&& other) noexcept
+                : owned_(std::move(other.owned_))
+                , mapping_(std::move(other.mapping_))
+                , data_(other.data_)
+                , size_(other.size_)
+        {
+            if (!mapping_)
+                Sync();
+            other.Sync();
+        }
+
+        Buffer& operator=(Buffer other) noexcept {
+            owned_ = std::move(other.owned_);
+            mapping_ = std::move(other.mapping_);
+            data_ = other.data_;
+            size_ = other.size_;
+            if (!mapping_)
+                Sync();
+            return *this;
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        const T* data() const {
+            return data_;
+        }
+
+        const T& operator[](size_t index) const {
+            return data_[index];
+        }
+
+        T& Mutable(size_t index) {
+            Own();
+            return owned_[index];
+        }
+
+        T* MutableData() {
+            Own();
+            return owned_.data();
+        }
+
+        void push_back(const T& value) {
+            Own();
+            owned_.push_back(value);
+            Sync();
+        }
+
+        void append(const T* values, size_t count) {
+            Own();
+            owned_.insert(owned_.end(), values, values + count);
+            Sync();
+        }
+
+        void reserve(size_t size) {
+            Own();
+            if (size > owned_.capacity())
+                owned_.reserve(std::max(size, owned_.capacity() * 2));
+            Sync();
+        }
+
+        void resize(size_t size) {
+            Own();
+            owned_.resize(size);
+            Sync();
+        }
+
+        void clear() {
+            owned_.clear();
+            mapping_.reset();
+            Sync();
+        }
+
+        void View(std::shared_ptr<const char> mapping, const T* data, size_t size) {
+            owned_ = std::vector<T>();
+            mapping_ = std::move(mapping);
+            data_ = data;
+            size_ = size;
+        }
+
+        size_t MemoryUsage() const {
+            return owned_.capacity() * sizeof(T);
+        }
+    };
+
+    class Bitmap {
+    private:
+        Buffer<uint64_t> words_;
+        size_t size_ = 0;
+
+    public:
+        Bitmap() = default;
+
+        explicit Bitmap(size_t size, bool value = false);
+
+        size_t Size() const;
+
+        bool Get(size_t index) const;
+
+        void Set(size_t index, bool value);
+
+        size_t Count() const;
+
+        size_t Next(size_t index) const;
+
+        const uint64_t* words() const;
+
+        uint64_t* MutableWords();
+
+        void PushBack(bool value);
+
+        void Reserve(size_t size);
+
+        void Clear();
+
+        size_t MemoryUsage() const;
+
+        void Save(Snapshot& snapshot) const;
+
+        bool Load(Snapshot& snapshot);
+    };
+
     class Column {
     private:
         Types type_;
         int width_;
+        Bitmap nulls_;
+        Buffer<int64_t> ints_;
+        Buffer<double> doubles_;
+        Bitmap bools_;
+        Buffer<uint64_t> offsets_ = {0};
+        Buffer<char> bytes_;
+        bool encoded_ = false;
+        Buffer<uint32_t> codes_;
+        Buffer<uint32_t> slots_;
+
+        // Once this many rows are encoded, a column whose distinct values exceed half its rows decodes for good.
+        static constexpr size_t kDictionaryMinRows = 1 << 10;
+
+        void AppendText(std::string_view value);
+
+        uint32_t Intern(std::string_view value);
+
+        void Rehash(size_t capacity);
+
+        void Decode();
 
     public:
+        static constexpr uint32_t kNoCode = UINT32_MAX;
+
         Column() = default;
 
-        Column(Types type, int width)
+        // A TEXT column built with encoded false stays plain: batches staged for another column, copies of plain ones.
+        Column(Types type, int width, bool encoded = true)
                 : type_(type)
                 , width_(width)
+                , encoded_(type == TEXT && encoded)
         {}
 
         Types type() const;
@@ -36,6 +254,84 @@ namespace DB {
         void SetWidth(int width);
 
         void CheckWidth(int width);
+
+        size_t Size() const;
+
+        size_t MemoryUsage() const;
+
+        bool IsNull(size_t index) const;
+
+        int64_t GetInt(size_t index) const;
+
+        double GetDouble(size_t index) const;
+
+        bool GetBool(size_t index) const;
+
+        std::string_view GetText(size_t index) const;
+
+        const Bitmap& nulls() const;
+
+        const int64_t* ints() const;
+
+        const double* doubles() const;
+
+        const Bitmap& bools() const;
+
+        // A TEXT column keeps each distinct value once and a code per row, until more than half of its rows
+        // hold distinct values; offsets and bytes then hold the dictionary instead of the rows.
+        bool encoded() const;
+
+        const uint32_t* codes() const;
+
+        size_t entries() const;
+
+        std::string_view Entry(uint32_t code) const;
+
+        // kNoCode when value is not in the dictionary.
+        uint32_t Code(std::string_view value) const;
+
+        std::string Key(size_t index) const;
+
+        static std::string MakeKey(Types type, const std::string& value);
+
+        std::string ToString(size_t index) const;
+
+        void Render(size_t index, std::string& out) const;
+
+        static bool IsValid(Types type, const std::string& value);
+
+        void Append(const std::string& value);
+
+        void AppendNull();
+
+        void AppendFrom(const Column& other, size_t index);
+
+        bool Parse(std::string_view value);
+
+        void AppendColumn(const Column& other);
+
+        void Reserve(size_t size);
+
+        // Drops every row and dictionary entry but keeps the allocations.
+        void Clear();
+
+        void Erase(const Bitmap& selected);
+
+        void Save(Snapshot& snapshot) const;
+
+        bool Load(Snapshot& snapshot);
+    };
+
+    class Predicate;
+
+    class LogRecord;
+
+    class WriteAheadLog;
+
+    enum Durability {
+        FSYNC_EACH,
+        GROUP_COMMIT,
+        OS_BUFFERED
     };
 
     class Condition {
@@ -60,49 +356,154 @@ namespace DB {
         const std::string& rhs() const;
     };
 
-    class Row {
+    enum Aggregates {
+        AGGREGATE_NONE,
+        AGGREGATE_COUNT,
+        AGGREGATE_SUM,
+        AGGREGATE_AVG,
+        AGGREGATE_MIN,
+        AGGREGATE_MAX
+    };
+
+    // One item of a grouped select list; AGGREGATE_NONE passes a group column through.
+    struct Aggregate {
+        Aggregates function = AGGREGATE_NONE;
+        std::string column;
+
+        std::string Name() const;
+    };
+
+    struct OrderBy {
+        std::string column;
+        bool descending = false;
+    };
+
+    // ORDER BY keys and the LIMIT/OFFSET window applied to a result before it is rendered.
+    struct Ordering {
+        std::vector<OrderBy> keys;
+        size_t limit = SIZE_MAX;
+        size_t offset = 0;
+
+        size_t needed() const;
+    };
+
+    struct KeyRange {
+        bool has_lower = false;
+        bool lower_inclusive = true;
+        std::string lower;
+        bool has_upper = false;
+        bool upper_inclusive = true;
+        std::string upper;
+    };
+
+    class Index {
     private:
-        std::map<std::string, std::string> data_;
+        std::string column_;
+        std::multimap<std::string, size_t> entries_;
 
     public:
-        Row() = default;
+        Index() = default;
 
-        explicit Row(const std::map<std::string, Column>& columns) {
-            for (auto& column : columns) {
-                data_.insert({column.first, ""});
-            }
-        }
+        explicit Index(const std::string& column)
+                : column_(column)
+        {}
+
+        const std::string& column() const;
+
+        void Insert(const std::string& key, size_t row);
+
+        void Erase(const std::string& key, size_t row);
+
+        void Clear();
 
-        void Concatenate(const Row& lhs, const Row& rhs);
+        void Range(const KeyRange& range, std::vector<size_t>& rows) const;
+    };
 
-        std::string Get(const std::string& name);
+    // Row versions carry the id of the transaction that created them (xmin) and the one that deleted them (xmax).
+    // A view sees an id if it is its own, or if it committed before the view was taken.
+    struct ReadView {
+        uint64_t xid = 0;
+        uint64_t limit = UINT64_MAX;
+        std::vector<uint64_t> active;
 
-        void Set(const std::string& name, const std::string& value);
+        bool Sees(uint64_t creator) const;
 
-        bool Suites(const std::map<std::string, Column>& columns) const;
+        uint64_t Horizon() const;
     };
 
     class Table {
     private:
-        std::vector<Row> rows_;
+        static constexpr size_t kCompactionMinRows = 1024;
+        static constexpr uint64_t kNever = UINT64_MAX;
+
+        size_t size_ = 0;
+        size_t dead_ = 0;
+        uint64_t horizon_ = 0;
+        uint64_t newest_ = 0;
+        Buffer<uint64_t> xmin_;
+        Buffer<uint64_t> xmax_;
         std::map<std::string, Column> columns_;
+        std::string primary_key_;
+        std::unordered_multimap<std::string, size_t> primary_index_;
+        std::map<std::string, Index> indexes_;
+        mutable std::shared_mutex latch_;
+        std::atomic<size_t> pins_{0};
+
+        void RebuildIndexes();
 
     public:
         Table() = default;
 
-        explicit Table(const std::map<std::string, Column>& columns)
+        explicit Table(const std::map<std::string, Column>& columns, const std::string& primary_key = "")
                 : columns_(columns)
+                , primary_key_(primary_key)
+        {}
+
+        // Adopts columns that already hold size rows, visible to every view.
+        Table(std::map<std::string, Column> columns, size_t size)
+                : size_(size)
+                , xmin_(size, 0)
+                , xmax_(size, kNever)
+                , columns_(std::move(columns))
         {}
 
         size_t Size();
 
-        std::map<std::string, Column> columns();
+        const std::map<std::string, Column>& columns() const;
+
+        const Column& GetColumn(const std::string& name) const;
+
+        const std::string& primary_key() const;
 
-        const Row& GetRow(int index);
+        std::shared_mutex& latch() const;
 
-        void AddRow(const Row& row);
+        void Pin();
 
-        void Insert(std::vector<std::string> columns, const std::vector<std::string>& values);
+        void Unpin();
+
+        bool pinned() const;
+
+        bool Lookup(const Predicate& predicate, std::vector<size_t>& rows) const;
+
+        // The index Lookup would use for predicate, or empty when it scans the whole table.
+        std::string AccessPath(const Predicate& predicate) const;
+
+        bool HasIndex(const std::string& name) const;
+
+        void CreateIndex(const std::string& name, const std::string& column);
+
+        void DropIndex(const std::string& name);
+
+        void AppendJoined(Table* lhs, int l, Table* rhs, int r);
+
+        // Drops every row but keeps the columns and their allocations, so a scratch table can be refilled.
+        void Clear();
+
+        bool Insert(std::vector<std::string> columns, const std::vector<std::vector<std::string>>& rows,
+                    const ReadView& view, std::string& message);
+
+        bool Append(const std::vector<std::string>& columns, const std::vector<std::vector<Column>>& batches,
+                    const ReadView& view, std::string& message);
 
         std::string Get(int index, const std::string& name);
 
@@ -110,89 +511,270 @@ namespace DB {
 
         bool IsColumnName(const std::string& value);
 
-        void Delete(const std::vector<bool>& selected);
+        bool IsVisible(size_t row, const ReadView& view) const;
+
+        void MaskVisible(const ReadView& view, size_t begin, size_t end, uint64_t* words) const;
+
+        Bitmap Visible(const ReadView& view) const;
 
-        void UpdateWidth(const std::string& name);
+        // Whether a transaction writing through view would overwrite a version it cannot see or one another
+        // transaction has already replaced; the first updater wins.
+        bool Conflicts(const Bitmap& rows, const ReadView& view) const;
 
-        void Update(const std::vector<std::pair<std::string, std::string>>& values, const std::vector<bool>& selected);
+        bool Delete(const Bitmap& selected, const ReadView& view, std::string& message);
+
+        // Replaced versions stay in place for older snapshots and the new ones are appended, so an unordered scan
+        // lists updated rows after the untouched ones.
+        bool Update(const std::vector<std::pair<std::string, std::string>>& values, const Bitmap& selected,
+                    const ReadView& view, std::string& message);
+
+        void Rollback(uint64_t xid);
+
+        bool Collectable(uint64_t horizon) const;
+
+        size_t Compact(uint64_t horizon);
+
+        void Save(Snapshot& snapshot) const;
+
+        bool Load(Snapshot& snapshot);
+    };
+
+    class Cursor {
+    private:
+        std::string message_;
+        std::shared_ptr<Table> table_;
+        std::vector<const Column*> columns_;
+        std::vector<std::string> names_;
+        std::vector<int> widths_;
+        Bitmap selected_;
+        bool ordered_ = false;
+        std::vector<size_t> order_;
+        ThreadPool* pool_ = nullptr;
+        Metrics* metrics_ = nullptr;
+        std::string divider_;
+        int stage_ = 0;
+        size_t row_ = 0;
+        std::vector<size_t> rows_;
+        std::vector<std::string> lines_;
+        size_t line_ = 0;
+
+        static constexpr size_t kRenderRows = 4096;
+        static constexpr size_t kRenderMorsel = 256;
+
+        void Render(size_t row, std::string& line) const;
+
+    public:
+        Cursor() = default;
+
+        explicit Cursor(const std::string& message)
+                : message_(message)
+        {}
+
+        Cursor(std::shared_ptr<Table> table, const std::vector<std::string>& columns, Bitmap selected,
+               ThreadPool* pool = nullptr, Metrics* metrics = nullptr);
+
+        Cursor(std::shared_ptr<Table> table, const std::vector<std::string>& columns, std::vector<size_t> order,
+               ThreadPool* pool = nullptr, Metrics* metrics = nullptr);
+
+        bool Next(std::string& line);
+
+        // True for a message that reports an error rather than success.
+        bool failed() const;
+    };
+
+    // An open transaction holds the database's writer lock from its first write until COMMIT or ROLLBACK: the log
+    // replays statements, not versions, in commit order, and that only reproduces the same rows when writers never
+    // interleave. Other writers wait at most MyAwesomeDB::kWriterTimeout for it and then fail with a lock timeout.
+    class Transaction {
+    private:
+        bool open_ = false;
+        uint64_t xid_ = 0;
+        ReadView view_;
+        std::unique_lock<std::timed_mutex> writer_;
+        std::vector<LogRecord> records_;
+        std::vector<std::shared_ptr<Table>> tables_;
+
+        friend class MyAwesomeDB;
+
+    public:
+        Transaction();
+
+        ~Transaction();
+
+        bool open() const;
     };
 
     class MyAwesomeDB {
     private:
-        std::map<std::string, Table*> tables_;
+        std::map<std::string, std::shared_ptr<Table>> tables_;
+        std::unique_ptr<WriteAheadLog> log_;
+        std::unique_ptr<ThreadPool> pool_;
+        std::unique_ptr<Metrics> metrics_;
+        std::string path_;
+        uint64_t generation_ = 0;
+        mutable std::shared_mutex catalog_;
+        std::timed_mutex writer_;
+        std::mutex state_;
+        uint64_t next_xid_ = 1;
+        std::vector<uint64_t> active_;
+        // Transactions whose log record is appended but not yet durable; they stay in active_ until it is.
+        std::vector<uint64_t> committing_;
+        std::condition_variable committed_;
+        std::multiset<uint64_t> horizons_;
+        bool stopping_ = false;
+        std::condition_variable collect_;
+        std::thread collector_;
+
+        static constexpr std::chrono::milliseconds kCollectInterval{100};
+
+        bool Log(const LogRecord& record, std::string& message);
+
+        bool Log(const std::vector<LogRecord>& records, std::string& message);
+
+        std::shared_ptr<Table> Find(const std::string& name) const;
+
+        static std::shared_ptr<Table> Pin(std::shared_ptr<Table> table);
+
+        ReadView MakeView(uint64_t xid);
+
+        ReadView MakeView(Transaction* transaction);
+
+        // Locks writer_ into writer, waiting at most kWriterTimeout; false with message set when it times out.
+        bool LockWriter(std::unique_lock<std::timed_mutex>& writer, std::string& message);
+
+        bool StartWrite(Transaction& transaction, std::string& message);
+
+        static void Touch(Transaction& transaction, const std::shared_ptr<Table>& table);
+
+        bool Finish(Transaction& transaction, bool commit, std::string& message);
 
-        static void StripSpaces(std::string& str);
+        uint64_t Horizon();
 
-        std::string GetColumnName(const std::string& value);
+        void Collect();
 
-        std::regex reg_dot_separated = std::regex(R"(\s*([\w_]+)\.([\w_]+)\s*)");
+        bool Ingest(Table* table, const std::vector<std::string>& columns, char delimiter,
+                    const std::vector<std::string_view>& chunks, size_t first_line, const ReadView& view,
+                    std::string& message);
+
+        void Apply(LogRecord& record);
+
+        bool Load(Snapshot& snapshot);
+
+        // Stops scanning once needed rows match, so the result may hold more than needed but never fewer.
+        Bitmap GetRows(Table* table, const std::string& name, const std::vector<std::vector<Condition>>& conditions,
+                       const ReadView& view, size_t needed = SIZE_MAX);
+
+        // Runs the join one morsel of outer rows at a time: each morsel's pairs are filtered by conditions in a scratch
+        // table holding only the columns they read, and the kept rows go to a chunk of the named columns. Chunks join
+        // up in morsel order, and no morsel starts once the ones before it hold needed rows, so the result may hold
+        // more than needed rows but never fewer.
+        Table* Join(const std::shared_ptr<Table>& lhs, const std::string& table_l, const std::shared_ptr<Table>& rhs,
+                    const std::string& table_r, const std::string& join_type,
+                    const std::vector<std::vector<Condition>>& join_on,
+                    const std::vector<std::vector<Condition>>& conditions, const std::vector<std::string>& columns,
+                    size_t needed, Transaction* transaction);
+
+        Cursor MakeOutput(std::shared_ptr<Table> table, const std::vector<std::string>& columns, Bitmap selected,
+                          const Ordering& ordering = Ordering());
+
+        Cursor Group(Table* table, const std::string& name, const Bitmap& selected,
+                     const std::vector<Aggregate>& aggregates, const std::vector<std::string>& group_by,
+                     const std::vector<std::string>& columns, const std::vector<std::vector<Condition>>& having,
+                     const Ordering& ordering);
 
     public:
-        MyAwesomeDB() = default;
+        static constexpr std::chrono::seconds kWriterTimeout{10};
 
-        ~MyAwesomeDB() {
-            for (auto& table : tables_) {
-                delete table.second;
-            }
-        }
+        MyAwesomeDB();
+
+        ~MyAwesomeDB();
+
+        bool Open(const std::string& path, Durability durability, std::string& message);
 
-        std::string MakeDivider(const std::string& table, const std::vector<std::string>& columns);
+        void SetParallelism(size_t threads);
 
-        std::vector<std::string> MakeOutput(const std::string& table, std::vector<std::string> columns,
-                                            const std::vector<bool>& selected, bool select_all);
+        size_t parallelism() const;
+
+        Metrics& metrics();
+
+        // The metrics registry's samples followed by gauges describing the catalog.
+        std::vector<MetricSample> Stats();
 
         static Types SeeType(const std::string& str);
 
-        void CreateTable(const std::string& name, const std::vector<std::pair<std::string, std::string>>& columns);
+        std::string CreateTable(const std::string& name, const std::vector<std::pair<std::string, std::string>>& columns,
+                                const std::string& primary_key = "");
+
+        std::string DeleteTable(const std::string& name);
 
-        void DeleteTable(const std::string& name);
+        std::string CreateIndex(const std::string& name, const std::string& table, const std::string& column);
 
-        std::vector<std::string> SelectAll(const std::string& table, const std::vector<std::string>& columns);
+        std::string DropIndex(const std::string& name);
 
-        static bool Check(int lhs, int rhs, const std::string& symbol);
+        std::string Begin(Transaction& transaction);
 
-        static bool Check(bool lhs, bool rhs, const std::string& symbol);
+        std::string Commit(Transaction& transaction);
 
-        static bool Check(double lhs, double rhs, const std::string& symbol);
+        std::string Rollback(Transaction& transaction);
 
-        static bool Check(const std::string& lhs, const std::string& rhs, const std::string& symbol);
+        Cursor SelectAll(const std::string& table, const std::vector<std::string>& columns,
+                         const Ordering& ordering = Ordering(), Transaction* transaction = nullptr);
 
-        std::string GetValue(std::map<std::string, int> indexes, std::string name);
+        Bitmap GetRows(const std::string& table, const std::vector<std::vector<Condition>>& conditions,
+                       Transaction* transaction = nullptr);
 
-        Types GetType(std::string table, std::string name);
+        // Describe how a WHERE on table, or a join of two tables, would run, without running it; false when a
+        // table does not exist.
+        bool ExplainScan(const std::string& table, const std::vector<std::vector<Condition>>& conditions,
+                         std::string& plan);
 
-        bool CheckCondition(const std::map<std::string, int>& indexes, const std::string& lhs,
-                            const std::string& rhs, const std::string& symbol);
+        bool ExplainJoin(const std::string& table_l, const std::string& table_r,
+                         const std::vector<std::vector<Condition>>& join_on, std::string& plan);
 
-        bool CheckRow(const std::map<std::string, int>& indexes,
-                      const std::vector<std::vector<Condition>>& conditions);
+        Cursor Select(const std::string& table, const std::vector<std::string>& columns,
+                      const std::vector<std::vector<Condition>>& conditions, const Ordering& ordering = Ordering(),
+                      Transaction* transaction = nullptr);
 
-        std::vector<bool> GetRows(const std::string& table, const std::vector<std::vector<Condition>>& conditions);
+        std::string Insert(const std::string& table, const std::vector<std::string>& columns,
+                           const std::vector<std::vector<std::string>>& values, Transaction* transaction = nullptr);
 
-        std::vector<std::string> Select(const std::string& table, const std::vector<std::string>& columns,
-                                        const std::vector<std::vector<Condition>>& conditions);
+        std::string Delete(const std::string& table, const std::vector<std::vector<Condition>>& conditions,
+                           Transaction* transaction = nullptr);
 
-        void Insert(const std::string& table, const std::vector<std::string>& columns, const std::vector<std::string>& values);
+        std::string Update(const std::string& table, const std::vector<std::pair<std::string, std::string>>& values,
+                           const std::vector<std::vector<Condition>>& conditions, Transaction* transaction = nullptr);
 
-        void Delete(const std::string& table, const std::vector<std::vector<Condition>>& conditions);
+        std::string Vacuum(const std::string& table);
 
-        void Update(const std::string& table, const std::vector<std::pair<std::string, std::string>>& values,
-                    const std::vector<std::vector<Condition>>& conditions);
+        std::string Copy(const std::string& table, std::vector<std::string> columns, const std::string& path,
+                         char delimiter, bool header, Transaction* transaction = nullptr);
 
-        Table* InnerJoin(const std::string& table_l, const std::string& table_r, const std::vector<std::vector<Condition>>& join_on);
+        std::string Checkpoint();
 
-        Table* LeftJoin(const std::string& table_l, const std::string& table_r, const std::vector<std::vector<Condition>>& join_on);
+        Cursor SelectAllJoined(const std::string& table_l, const std::string& table_r,
+                               const std::string& join_type, const std::vector<std::vector<Condition>>& join_on,
+                               const std::vector<std::string>& columns, const Ordering& ordering = Ordering(),
+                               Transaction* transaction = nullptr);
 
-        Table* RightJoin(const std::string& table_l, const std::string& table_r, const std::vector<std::vector<Condition>>& join_on);
+        Cursor SelectJoined(const std::string& table_l, const std::string& table_r,
+                            const std::string& join_type, const std::vector<std::vector<Condition>>& join_on,
+                            const std::vector<std::string>& columns,
+                            const std::vector<std::vector<Condition>>& conditions,
+                            const Ordering& ordering = Ordering(), Transaction* transaction = nullptr);
 
-        std::vector<std::string> SelectAllJoined(const std::string& table_l, const std::string& table_r,
-                                                 const std::string& join_type, const std::vector<std::vector<Condition>>& join_on,
-                                                 const std::vector<std::string>& columns);
+        Cursor SelectGrouped(const std::string& table, const std::vector<Aggregate>& aggregates,
+                             const std::vector<std::string>& group_by, const std::vector<std::string>& columns,
+                             const std::vector<std::vector<Condition>>& conditions,
+                             const std::vector<std::vector<Condition>>& having, const Ordering& ordering = Ordering(),
+                             Transaction* transaction = nullptr);
 
-        std::vector<std::string> SelectJoined(const std::string& table_l, const std::string& table_r,
-                                              const std::string& join_type, const std::vector<std::vector<Condition>>& join_on,
-                                              const std::vector<std::string>& columns,
-                                              const std::vector<std::vector<Condition>>& conditions);
+        Cursor SelectGroupedJoined(const std::string& table_l, const std::string& table_r,
+                                   const std::string& join_type, const std::vector<std::vector<Condition>>& join_on,
+                                   const std::vector<Aggregate>& aggregates, const std::vector<std::string>& group_by,
+                                   const std::vector<std::string>& columns,
+                                   const std::vector<std::vector<Condition>>& conditions,
+                                   const std::vector<std::vector<Condition>>& having,
+                                   const Ordering& ordering = Ordering(), Transaction* transaction = nullptr);
     };
 
 }
@@ -0,0 +1,164 @@
+#include "join.h"
+#include "profile.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace DB;
+
+// Text keys are looked up in place; the other types encode into a few bytes that fit the buffer's inline storage.
+static std::string_view Key(const Column* column, size_t row, std::string& buffer) {
+    if (column->type() == TEXT)
+        return column->GetText(row);
+    buffer = column->Key(row);
+
+    return buffer;
+}
+
+JoinMatcher::JoinMatcher(Table* lhs, const Bitmap& lhs_rows, Table* rhs, const Bitmap& rhs_rows,
+                         const Predicate& predicate, ThreadPool& pool)
+        : rhs_(rhs)
+        , lhs_rows_(lhs_rows)
+        , rhs_rows_(rhs_rows)
+        , predicate_(predicate)
+{
+    const Column* lhs_key;
+    const Column* rhs_key;
+    if (!predicate.EquiJoinKey(lhs_key, rhs_key))
+        return;
+    build_left_ = lhs->Size() < rhs->Size();
+    build_ = build_left_ ? lhs_key : rhs_key;
+    probe_ = build_left_ ? rhs_key : lhs_key;
+    coded_ = build_->encoded();
+    Build();
+    if (build_left_)
+        ProbeAll(pool);
+}
+
+void JoinMatcher::Build() {
+    PROFILE_SCOPE(stage, "hash build");
+    const Bitmap& build_rows = build_left_ ? lhs_rows_ : rhs_rows_;
+    next_.assign(build_->Size(), SIZE_MAX);
+    if (coded_) {
+        code_heads_.assign(build_->entries(), SIZE_MAX);
+        for (size_t i = build_->Size(); i-- > 0;) {
+            if (!build_rows.Get(i) || build_->IsNull(i))
+                continue;
+            next_[i] = code_heads_[build_->codes()[i]];
+            code_heads_[build_->codes()[i]] = i;
+        }
+        if (probe_->encoded()) {
+            translated_.resize(probe_->entries());
+            for (uint32_t code = 0; code < probe_->entries(); ++code) {
+                translated_[code] = build_->Code(probe_->Entry(code));
+            }
+        }
+    } else {
+        heads_.reserve(build_->Size());
+        for (size_t i = build_->Size(); i-- > 0;) {
+            if (!build_rows.Get(i) || build_->IsNull(i))
+                continue;
+            std::string buffer;
+            std::string_view view = Key(build_, i, buffer);
+            auto head = heads_.find(view);
+            if (head == heads_.end()) {
+                heads_.emplace(build_->type() == TEXT ? view : Arena::Local().Copy(view), i);
+            } else {
+                next_[i] = head->second;
+                head->second = i;
+            }
+        }
+    }
+    PROFILE(if (stage.active()) {
+        stage.Detail(coded_ ? "on dictionary codes" : "");
+        stage.Rows(build_rows.Count(), coded_ ? build_->entries() : heads_.size());
+    });
+}
+
+void JoinMatcher::ProbeAll(ThreadPool& pool) {
+    PROFILE_SCOPE(stage, "hash probe");
+    PROFILE(std::atomic<size_t> evaluations(0));
+    std::vector<std::vector<std::pair<size_t, size_t>>> parts((rhs_->Size() + kMorselRows - 1) / kMorselRows);
+    pool.ParallelFor(rhs_->Size(), kMorselRows, [&](size_t begin, size_t end) {
+        auto& part = parts[begin / kMorselRows];
+        PROFILE(size_t evaluated = 0);
+        size_t rows[2];
+        for (rows[1] = begin; rows[1] < end; ++rows[1]) {
+            if (!rhs_rows_.Get(rows[1]) || probe_->IsNull(rows[1]))
+                continue;
+            for (rows[0] = First(rows[1]); rows[0] != SIZE_MAX; rows[0] = next_[rows[0]]) {
+                PROFILE(++evaluated);
+                if (predicate_.Evaluate(rows))
+                    part.emplace_back(rows[0], rows[1]);
+            }
+        }
+        PROFILE(evaluations += evaluated);
+    });
+    for (auto& part : parts) {
+        pairs_.insert(pairs_.end(), part.begin(), part.end());
+    }
+    std::sort(pairs_.begin(), pairs_.end());
+    PROFILE(if (stage.active()) {
+        stage.Detail("ahead of the lhs morsels");
+        stage.Rows(rhs_rows_.Count(), pairs_.size());
+        stage.Evaluations(evaluations);
+    });
+}
+
+size_t JoinMatcher::First(size_t row) const {
+    if (!coded_) {
+        std::string buffer;
+        auto head = heads_.find(Key(probe_, row, buffer));
+        return head == heads_.end() ? SIZE_MAX : head->second;
+    }
+    uint32_t code = probe_->encoded() ? translated_[probe_->codes()[row]] : build_->Code(probe_->GetText(row));
+
+    return code == Column::kNoCode ? SIZE_MAX : code_heads_[code];
+}
+
+const char* JoinMatcher::method() const {
+    if (build_ == nullptr)
+        return "nested loop";
+
+    return build_left_ ? "sorted hash matches" : "hash probe";
+}
+
+size_t JoinMatcher::morsel() const {
+    if (build_ == nullptr)
+        return std::max<size_t>(1, kMorselRows / std::max<size_t>(1, rhs_->Size()));
+
+    return kMorselRows;
+}
+
+size_t JoinMatcher::Probe(size_t begin, size_t end, bool left, ArenaVector<std::pair<size_t, size_t>>& pairs) const {
+    size_t evaluations = 0;
+    auto match = std::lower_bound(pairs_.begin(), pairs_.end(), std::make_pair(begin, size_t(0)));
+    size_t rows[2];
+    for (rows[0] = begin; rows[0] < end; ++rows[0]) {
+        if (!lhs_rows_.Get(rows[0]))
+            continue;
+        size_t matched = pairs.size();
+        if (build_ == nullptr) {
+            for (rows[1] = rhs_rows_.Next(0); rows[1] < rhs_rows_.Size(); rows[1] = rhs_rows_.Next(rows[1] + 1)) {
+                ++evaluations;
+                if (predicate_.Evaluate(rows))
+                    pairs.emplace_back(rows[0], rows[1]);
+            }
+        } else if (build_left_) {
+            for (; match != pairs_.end() && match->first == rows[0]; ++match) {
+                pairs.push_back(*match);
+            }
+        } else if (!probe_->IsNull(rows[0])) {
+            for (rows[1] = First(rows[0]); rows[1] != SIZE_MAX; rows[1] = next_[rows[1]]) {
+                ++evaluations;
+                if (predicate_.Evaluate(rows))
+                    pairs.emplace_back(rows[0], rows[1]);
+            }
+        }
+        if (left && pairs.size() == matched)
+            pairs.emplace_back(rows[0], SIZE_MAX);
+    }
+
+    return evaluations;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "arena.h"
+#include "predicate.h"
+
+#include <unordered_map>
+
+namespace DB {
+
+    class ThreadPool;
+
+    // Pairs the visible rows of two tables. An equality join hashes the smaller side and probes it with the other;
+    // any other join runs a nested loop. Probe lists the pairs of a range of lhs rows in (lhs, rhs) order, so a join
+    // can run one morsel of lhs rows at a time. An lhs build side can only be probed by rhs rows, so those pairs are
+    // all found up front, sorted, and sliced by Probe. The hash table lives in the arena of the thread that built the
+    // matcher, whose ArenaScope must outlive it; probing only reads it.
+    class JoinMatcher {
+    private:
+        Table* rhs_;
+        const Bitmap& lhs_rows_;
+        const Bitmap& rhs_rows_;
+        const Predicate& predicate_;
+        // Null for a nested loop.
+        const Column* build_ = nullptr;
+        const Column* probe_ = nullptr;
+        bool build_left_ = false;
+        // A dictionary-encoded build side chains its rows per code, and the probe side finds the code of each of its
+        // dictionary entries once.
+        bool coded_ = false;
+        std::unordered_map<std::string_view, size_t, std::hash<std::string_view>, std::equal_to<>,
+                           ArenaAllocator<std::pair<const std::string_view, size_t>>> heads_;
+        ArenaVector<size_t> code_heads_;
+        ArenaVector<uint32_t> translated_;
+        ArenaVector<size_t> next_;
+        std::vector<std::pair<size_t, size_t>> pairs_;
+
+        void Build();
+
+        void ProbeAll(ThreadPool& pool);
+
+        // The first build row whose key equals that of probe row row, or SIZE_MAX.
+        size_t First(size_t row) const;
+
+    public:
+        JoinMatcher(Table* lhs, const Bitmap& lhs_rows, Table* rhs, const Bitmap& rhs_rows, const Predicate& predicate,
+                    ThreadPool& pool);
+
+        // How the pairs are found, for EXPLAIN ANALYZE.
+        const char* method() const;
+
+        // Lhs rows per morsel, sized so a morsel makes about kMorselRows predicate calls in a nested loop.
+        size_t morsel() const;
+
+        // Appends the pairs of the selected lhs rows in [begin, end); with left set, an lhs row without a match pairs
+        // with SIZE_MAX. Returns the number of predicate calls made.
+        size_t Probe(size_t begin, size_t end, bool left, ArenaVector<std::pair<size_t, size_t>>& pairs) const;
+    };
+
+}
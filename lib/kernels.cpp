@@ -0,0 +1,303 @@
+#include "kernels.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using namespace DB;
+
+using IntKernel = void (*)(const int64_t*, const int64_t*, int64_t, size_t, uint64_t*);
+
+using DoubleKernel = void (*)(const double*, const double*, double, size_t, uint64_t*);
+
+using CodeKernel = void (*)(const uint32_t*, uint32_t, size_t, uint64_t*);
+
+struct KernelSet {
+    const char* name;
+    IntKernel ints[6][2];
+    DoubleKernel doubles[6][2];
+    CodeKernel codes[2];
+};
+
+template <Operators op, typename T>
+static bool Apply(T lhs, T rhs) {
+    if constexpr (op == LESS)
+        return lhs < rhs;
+    else if constexpr (op == LESS_EQUAL)
+        return lhs <= rhs;
+    else if constexpr (op == GREATER)
+        return lhs > rhs;
+    else if constexpr (op == GREATER_EQUAL)
+        return lhs >= rhs;
+    else if constexpr (op == EQUAL)
+        return lhs == rhs;
+    else
+        return lhs != rhs;
+}
+
+template <Operators op, bool Constant, typename T>
+static void CompareScalar(const T* lhs, const T* rhs, T constant, size_t count, uint64_t* out) {
+    for (size_t base = 0; base < count; base += 64) {
+        size_t size = std::min<size_t>(64, count - base);
+        uint64_t mask = 0;
+        for (size_t i = 0; i < size; ++i) {
+            mask |= uint64_t(Apply<op>(lhs[base + i], Constant ? constant : rhs[base + i])) << i;
+        }
+        out[base / 64] = mask;
+    }
+}
+
+template <Operators op, bool Constant>
+struct Scalar {
+    static void Ints(const int64_t* lhs, const int64_t* rhs, int64_t constant, size_t count, uint64_t* out) {
+        CompareScalar<op, Constant>(lhs, rhs, constant, count, out);
+    }
+
+    static void Doubles(const double* lhs, const double* rhs, double constant, size_t count, uint64_t* out) {
+        CompareScalar<op, Constant>(lhs, rhs, constant, count, out);
+    }
+
+    static void Codes(const uint32_t* lhs, uint32_t constant, size_t count, uint64_t* out) {
+        CompareScalar<op, true>(lhs, lhs, constant, count, out);
+    }
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Integer compares only come as greater-than and equal; the other operators swap the operands or invert
+// the finished word, which is exact for integers. Doubles use the ordered predicates directly so NaN
+// behaves as it does in the scalar path.
+template <Operators op>
+static constexpr bool kInverted = op == LESS_EQUAL || op == GREATER_EQUAL || op == NOT_EQUAL;
+
+template <Operators op>
+static constexpr int kDoublePredicate = op == LESS ? _CMP_LT_OQ : op == LESS_EQUAL ? _CMP_LE_OQ :
+                                        op == GREATER ? _CMP_GT_OQ : op == GREATER_EQUAL ? _CMP_GE_OQ :
+                                        op == EQUAL ? _CMP_EQ_OQ : _CMP_NEQ_UQ;
+
+template <Operators op, bool Constant>
+struct Avx2 {
+    __attribute__((target("avx2")))
+    static void Ints(const int64_t* lhs, const int64_t* rhs, int64_t constant, size_t count, uint64_t* out) {
+        __m256i broadcast = _mm256_set1_epi64x(constant);
+        size_t words = count / 64;
+        for (size_t word = 0; word < words; ++word) {
+            uint64_t mask = 0;
+            for (size_t i = 0; i < 64; i += 4) {
+                size_t row = word * 64 + i;
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + row));
+                __m256i b = Constant ? broadcast : _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + row));
+                __m256i result;
+                if constexpr (op == LESS || op == GREATER_EQUAL)
+                    result = _mm256_cmpgt_epi64(b, a);
+                else if constexpr (op == GREATER || op == LESS_EQUAL)
+                    result = _mm256_cmpgt_epi64(a, b);
+                else
+                    result = _mm256_cmpeq_epi64(a, b);
+                mask |= uint64_t(_mm256_movemask_pd(_mm256_castsi256_pd(result))) << i;
+            }
+            out[word] = kInverted<op> ? ~mask : mask;
+        }
+        if (count % 64 != 0)
+            CompareScalar<op, Constant>(lhs + words * 64, Constant ? rhs : rhs + words * 64, constant, count % 64,
+                                        out + words);
+    }
+
+    __attribute__((target("avx2")))
+    static void Doubles(const double* lhs, const double* rhs, double constant, size_t count, uint64_t* out) {
+        __m256d broadcast = _mm256_set1_pd(constant);
+        size_t words = count / 64;
+        for (size_t word = 0; word < words; ++word) {
+            uint64_t mask = 0;
+            for (size_t i = 0; i < 64; i += 4) {
+                size_t row = word * 64 + i;
+                __m256d a = _mm256_loadu_pd(lhs + row);
+                __m256d b = Constant ? broadcast : _mm256_loadu_pd(rhs + row);
+                mask |= uint64_t(_mm256_movemask_pd(_mm256_cmp_pd(a, b, kDoublePredicate<op>))) << i;
+            }
+            out[word] = mask;
+        }
+        if (count % 64 != 0)
+            CompareScalar<op, Constant>(lhs + words * 64, Constant ? rhs : rhs + words * 64, constant, count % 64,
+                                        out + words);
+    }
+
+    __attribute__((target("avx2")))
+    static void Codes(const uint32_t* lhs, uint32_t constant, size_t count, uint64_t* out) {
+        __m256i broadcast = _mm256_set1_epi32(static_cast<int>(constant));
+        size_t words = count / 64;
+        for (size_t word = 0; word < words; ++word) {
+            uint64_t mask = 0;
+            for (size_t i = 0; i < 64; i += 8) {
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + word * 64 + i));
+                __m256i result = _mm256_cmpeq_epi32(a, broadcast);
+                mask |= uint64_t(_mm256_movemask_ps(_mm256_castsi256_ps(result))) << i;
+            }
+            out[word] = kInverted<op> ? ~mask : mask;
+        }
+        if (count % 64 != 0)
+            CompareScalar<op, true>(lhs + words * 64, lhs, constant, count % 64, out + words);
+    }
+};
+
+template <Operators op, bool Constant>
+struct Sse42 {
+    __attribute__((target("sse4.2")))
+    static void Ints(const int64_t* lhs, const int64_t* rhs, int64_t constant, size_t count, uint64_t* out) {
+        __m128i broadcast = _mm_set1_epi64x(constant);
+        size_t words = count / 64;
+        for (size_t word = 0; word < words; ++word) {
+            uint64_t mask = 0;
+            for (size_t i = 0; i < 64; i += 2) {
+                size_t row = word * 64 + i;
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + row));
+                __m128i b = Constant ? broadcast : _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + row));
+                __m128i result;
+                if constexpr (op == LESS || op == GREATER_EQUAL)
+                    result = _mm_cmpgt_epi64(b, a);
+                else if constexpr (op == GREATER || op == LESS_EQUAL)
+                    result = _mm_cmpgt_epi64(a, b);
+                else
+                    result = _mm_cmpeq_epi64(a, b);
+                mask |= uint64_t(_mm_movemask_pd(_mm_castsi128_pd(result))) << i;
+            }
+            out[word] = kInverted<op> ? ~mask : mask;
+        }
+        if (count % 64 != 0)
+            CompareScalar<op, Constant>(lhs + words * 64, Constant ? rhs : rhs + words * 64, constant, count % 64,
+                                        out + words);
+    }
+
+    __attribute__((target("sse4.2")))
+    static void Doubles(const double* lhs, const double* rhs, double constant, size_t count, uint64_t* out) {
+        __m128d broadcast = _mm_set1_pd(constant);
+        size_t words = count / 64;
+        for (size_t word = 0; word < words; ++word) {
+            uint64_t mask = 0;
+            for (size_t i = 0; i < 64; i += 2) {
+                size_t row = word * 64 + i;
+                __m128d a = _mm_loadu_pd(lhs + row);
+                __m128d b = Constant ? broadcast : _mm_loadu_pd(rhs + row);
+                __m128d result;
+                if constexpr (op == LESS)
+                    result = _mm_cmplt_pd(a, b);
+                else if constexpr (op == LESS_EQUAL)
+                    result = _mm_cmple_pd(a, b);
+                else if constexpr (op == GREATER)
+                    result = _mm_cmpgt_pd(a, b);
+                else if constexpr (op == GREATER_EQUAL)
+                    result = _mm_cmpge_pd(a, b);
+                else if constexpr (op == EQUAL)
+                    result = _mm_cmpeq_pd(a, b);
+                else
+                    result = _mm_cmpneq_pd(a, b);
+                mask |= uint64_t(_mm_movemask_pd(result)) << i;
+            }
+            out[word] = mask;
+        }
+        if (count % 64 != 0)
+            CompareScalar<op, Constant>(lhs + words * 64, Constant ? rhs : rhs + words * 64, constant, count % 64,
+                                        out + words);
+    }
+
+    __attribute__((target("sse4.2")))
+    static void Codes(const uint32_t* lhs, uint32_t constant, size_t count, uint64_t* out) {
+        __m128i broadcast = _mm_set1_epi32(static_cast<int>(constant));
+        size_t words = count / 64;
+        for (size_t word = 0; word < words; ++word) {
+            uint64_t mask = 0;
+            for (size_t i = 0; i < 64; i += 4) {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + word * 64 + i));
+                __m128i result = _mm_cmpeq_epi32(a, broadcast);
+                mask |= uint64_t(_mm_movemask_ps(_mm_castsi128_ps(result))) << i;
+            }
+            out[word] = kInverted<op> ? ~mask : mask;
+        }
+        if (count % 64 != 0)
+            CompareScalar<op, true>(lhs + words * 64, lhs, constant, count % 64, out + words);
+    }
+};
+
+#endif
+
+template <template <Operators, bool> class Isa, Operators op>
+static void Fill(KernelSet& set) {
+    set.ints[op][0] = &Isa<op, false>::Ints;
+    set.ints[op][1] = &Isa<op, true>::Ints;
+    set.doubles[op][0] = &Isa<op, false>::Doubles;
+    set.doubles[op][1] = &Isa<op, true>::Doubles;
+}
+
+template <template <Operators, bool> class Isa>
+static KernelSet MakeSet(const char* name) {
+    KernelSet set{};
+    set.name = name;
+    Fill<Isa, LESS>(set);
+    Fill<Isa, LESS_EQUAL>(set);
+    Fill<Isa, GREATER>(set);
+    Fill<Isa, GREATER_EQUAL>(set);
+    Fill<Isa, EQUAL>(set);
+    Fill<Isa, NOT_EQUAL>(set);
+    set.codes[0] = &Isa<EQUAL, true>::Codes;
+    set.codes[1] = &Isa<NOT_EQUAL, true>::Codes;
+
+    return set;
+}
+
+static const KernelSet kScalar = MakeSet<Scalar>("scalar");
+
+#if defined(__x86_64__) || defined(__i386__)
+
+static const KernelSet kSse42 = MakeSet<Sse42>("sse4.2");
+
+static const KernelSet kAvx2 = MakeSet<Avx2>("avx2");
+
+static const KernelSet* Find(const std::string& name) {
+    __builtin_cpu_init();
+    if ((name.empty() || name == "avx2") && __builtin_cpu_supports("avx2"))
+        return &kAvx2;
+    if ((name.empty() || name == "sse4.2") && __builtin_cpu_supports("sse4.2"))
+        return &kSse42;
+    if (name.empty() || name == "scalar")
+        return &kScalar;
+    return nullptr;
+}
+
+#else
+
+static const KernelSet* Find(const std::string& name) {
+    return name.empty() || name == "scalar" ? &kScalar : nullptr;
+}
+
+#endif
+
+static const KernelSet* active = Find("");
+
+void DB::CompareInts(Operators op, const int64_t* lhs, const int64_t* rhs, int64_t constant, size_t count,
+                     uint64_t* out) {
+    active->ints[op][rhs == nullptr](lhs, rhs, constant, count, out);
+}
+
+void DB::CompareDoubles(Operators op, const double* lhs, const double* rhs, double constant, size_t count,
+                        uint64_t* out) {
+    active->doubles[op][rhs == nullptr](lhs, rhs, constant, count, out);
+}
+
+void DB::CompareCodes(Operators op, const uint32_t* lhs, uint32_t constant, size_t count, uint64_t* out) {
+    active->codes[op == NOT_EQUAL](lhs, constant, count, out);
+}
+
+const char* DB::KernelName() {
+    return active->name;
+}
+
+bool DB::UseKernels(const std::string& name) {
+    const KernelSet* set = Find(name);
+    if (set == nullptr)
+        return false;
+    active = set;
+
+    return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace DB {
+
+    enum Operators {
+        LESS,
+        LESS_EQUAL,
+        GREATER,
+        GREATER_EQUAL,
+        EQUAL,
+        NOT_EQUAL
+    };
+
+    // Compares count values against rhs, or against constant when rhs is null, and writes one bit per
+    // value into (count + 63) / 64 words of out. Bits past count in the last word are cleared.
+    void CompareInts(Operators op, const int64_t* lhs, const int64_t* rhs, int64_t constant, size_t count,
+                     uint64_t* out);
+
+    void CompareDoubles(Operators op, const double* lhs, const double* rhs, double constant, size_t count,
+                        uint64_t* out);
+
+    // Dictionary codes only compare as EQUAL or NOT_EQUAL.
+    void CompareCodes(Operators op, const uint32_t* lhs, uint32_t constant, size_t count, uint64_t* out);
+
+    const char* KernelName();
+
+    bool UseKernels(const std::string& name);
+
+}
@@ -0,0 +1,134 @@
+#include "loader.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace DB;
+
+bool Loader::Map(const std::string& path, std::shared_ptr<const char>& data, size_t& size) {
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    size = status.st_size;
+    if (size == 0) {
+        close(fd);
+        data = std::shared_ptr<const char>("", [](const char*) {});
+        return true;
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    data = std::shared_ptr<const char>(static_cast<const char*>(mapped), [size](const char* pointer) {
+        munmap(const_cast<char*>(pointer), size);
+    });
+
+    return true;
+}
+
+void Loader::Split(std::string_view data, size_t threads, std::vector<std::string_view>& chunks) {
+    size_t size = std::clamp(data.size() / (threads * 4), kMinChunkSize, kMaxChunkSize);
+    while (!data.empty()) {
+        size_t end = data.size() <= size ? std::string_view::npos : data.find('\n', size);
+        end = end == std::string_view::npos ? data.size() : end + 1;
+        chunks.emplace_back(data.substr(0, end));
+        data.remove_prefix(end);
+    }
+}
+
+bool Loader::Parse(std::string_view chunk, std::vector<Column>& batch, size_t& line, std::string& message) const {
+    for (auto type : types_) {
+        batch.emplace_back(type, 0, false);
+    }
+    std::string unquoted;
+    line = 0;
+    while (!chunk.empty()) {
+        size_t end = chunk.find('\n');
+        std::string_view text = chunk.substr(0, end);
+        chunk.remove_prefix(end == std::string_view::npos ? chunk.size() : end + 1);
+        ++line;
+        if (!text.empty() && text.back() == '\r')
+            text.remove_suffix(1);
+        if (text.empty())
+            continue;
+        size_t field = 0;
+        size_t position = 0;
+        while (true) {
+            std::string_view value;
+            bool quoted = position < text.size() && text[position] == '"';
+            if (quoted) {
+                unquoted.clear();
+                ++position;
+                while (position < text.size()) {
+                    if (text[position] == '"' && (position + 1 == text.size() || text[position + 1] != '"'))
+                        break;
+                    position += text[position] == '"' ? 1 : 0;
+                    unquoted += text[position++];
+                }
+                if (position == text.size()) {
+                    message = "UNTERMINATED QUOTE";
+                    return false;
+                }
+                ++position;
+                value = unquoted;
+            } else {
+                size_t next = text.find(delimiter_, position);
+                value = text.substr(position, next == std::string_view::npos ? std::string_view::npos : next - position);
+                position += value.size();
+            }
+            if (field < batch.size()) {
+                if (!quoted && value.empty()) {
+                    batch[field].AppendNull();
+                } else if (!batch[field].Parse(value)) {
+                    message = "INVALID VALUE " + std::string(value) + " FOR COLUMN " + names_[field];
+                    return false;
+                }
+            }
+            ++field;
+            if (position == text.size())
+                break;
+            if (text[position] != delimiter_) {
+                message = "EXPECTED DELIMITER";
+                return false;
+            }
+            ++position;
+        }
+        if (field != batch.size()) {
+            message = "EXPECTED " + std::to_string(batch.size()) + " VALUES, GOT " + std::to_string(field);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Loader::Load(const std::vector<std::string_view>& chunks, size_t first_line, ThreadPool& pool,
+                  std::vector<std::vector<Column>>& batches, std::string& message) const {
+    batches.assign(chunks.size(), {});
+    std::vector<size_t> lines(chunks.size());
+    std::vector<std::string> errors(chunks.size());
+    std::vector<char> failed(chunks.size());
+    pool.ParallelFor(chunks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            failed[i] = !Parse(chunks[i], batches[i], lines[i], errors[i]);
+        }
+    });
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (failed[i]) {
+            message = "-- " + errors[i] + " AT LINE " + std::to_string(first_line + lines[i]) + " --\n";
+            return false;
+        }
+        first_line += lines[i];
+    }
+
+    return true;
+}
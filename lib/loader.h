@@ -0,0 +1,34 @@
+#pragma once
+
+#include "database.h"
+
+namespace DB {
+
+    class Loader {
+    private:
+        static constexpr size_t kMinChunkSize = 1 << 20;
+        static constexpr size_t kMaxChunkSize = 64 << 20;
+
+        std::vector<std::string> names_;
+        std::vector<Types> types_;
+        char delimiter_;
+
+        bool Parse(std::string_view chunk, std::vector<Column>& batch, size_t& line, std::string& message) const;
+
+    public:
+        Loader(const std::vector<std::string>& names, const std::vector<Types>& types, char delimiter)
+                : names_(names)
+                , types_(types)
+                , delimiter_(delimiter)
+        {}
+
+        static bool Map(const std::string& path, std::shared_ptr<const char>& data, size_t& size);
+
+        static void Split(std::string_view data, size_t threads, std::vector<std::string_view>& chunks);
+
+        // Parses the chunks on the pool, one chunk per morsel.
+        bool Load(const std::vector<std::string_view>& chunks, size_t first_line, ThreadPool& pool,
+                  std::vector<std::vector<Column>>& batches, std::string& message) const;
+    };
+
+}
@@ -0,0 +1,174 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+using namespace DB;
+
+static const char* kKinds[] = {"select", "insert", "update", "delete", "ddl", "copy", "transaction", "other", "error"};
+static const char* kCounters[] = {"db_rows_scanned_total", "db_rows_returned_total"};
+
+static std::atomic<uint64_t> next_id(1);
+
+size_t Histogram::Bucket(uint64_t value) {
+    if (value < (uint64_t(1) << kSubBits))
+        return value;
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent >= kMaxBits)
+        return kBuckets - 1;
+
+    return (size_t(exponent - kSubBits + 1) << kSubBits) + ((value >> (exponent - kSubBits)) & ((1 << kSubBits) - 1));
+}
+
+void Histogram::Add(size_t bucket, uint64_t count) {
+    buckets_[bucket] += count;
+}
+
+void Histogram::AddSum(uint64_t sum, uint64_t max) {
+    sum_ += sum;
+    max_ = std::max(max_, max);
+}
+
+uint64_t Histogram::count() const {
+    uint64_t count = 0;
+    for (auto bucket : buckets_) {
+        count += bucket;
+    }
+
+    return count;
+}
+
+uint64_t Histogram::sum() const {
+    return sum_;
+}
+
+uint64_t Histogram::Quantile(double quantile) const {
+    uint64_t rank = std::max<uint64_t>(1, std::ceil(quantile * count()));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+        seen += buckets_[bucket];
+        if (seen < rank)
+            continue;
+        if (bucket < (size_t(1) << kSubBits))
+            return bucket;
+        int shift = (bucket >> kSubBits) - 1;
+        uint64_t lower = ((uint64_t(1) << kSubBits) + (bucket & ((1 << kSubBits) - 1))) << shift;
+        return std::min(max_, lower + (uint64_t(1) << shift) / 2);
+    }
+
+    return max_;
+}
+
+Metrics::Metrics()
+        : id_(next_id++)
+        , start_(std::chrono::steady_clock::now())
+{}
+
+Metrics::Shard& Metrics::Local() {
+    static thread_local uint64_t cached_id = 0;
+    static thread_local Shard* cached = nullptr;
+    if (cached_id == id_)
+        return *cached;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = std::find_if(shards_.begin(), shards_.end(), [](const std::unique_ptr<Shard>& shard) {
+        return shard->owner == std::this_thread::get_id();
+    });
+    if (found == shards_.end()) {
+        shards_.emplace_back(std::make_unique<Shard>());
+        shards_.back()->owner = std::this_thread::get_id();
+        found = shards_.end() - 1;
+    }
+    cached_id = id_;
+    cached = found->get();
+
+    return *cached;
+}
+
+void Metrics::Count(Counter counter, uint64_t value) {
+    Bump(Local().counters[counter], value);
+}
+
+void Metrics::Record(StatementKind kind, std::chrono::steady_clock::duration latency) {
+    uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+    Shard& shard = Local();
+    Bump(shard.latencies[kind][Histogram::Bucket(nanoseconds)], 1);
+    Bump(shard.sums[kind], nanoseconds);
+    if (nanoseconds > shard.maxima[kind].load(std::memory_order_relaxed))
+        shard.maxima[kind].store(nanoseconds, std::memory_order_relaxed);
+}
+
+std::vector<MetricSample> Metrics::Collect() const {
+    std::vector<Histogram> latencies(STATEMENT_KINDS);
+    std::array<uint64_t, COUNTERS> counters{};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& shard : shards_) {
+            for (size_t counter = 0; counter < COUNTERS; ++counter) {
+                counters[counter] += shard->counters[counter].load(std::memory_order_relaxed);
+            }
+            for (size_t kind = 0; kind < STATEMENT_KINDS; ++kind) {
+                for (size_t bucket = 0; bucket < Histogram::kBuckets; ++bucket) {
+                    uint64_t count = shard->latencies[kind][bucket].load(std::memory_order_relaxed);
+                    if (count != 0)
+                        latencies[kind].Add(bucket, count);
+                }
+                latencies[kind].AddSum(shard->sums[kind].load(std::memory_order_relaxed),
+                                       shard->maxima[kind].load(std::memory_order_relaxed));
+            }
+        }
+    }
+    double uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+
+    std::vector<MetricSample> samples;
+    samples.push_back({"db_uptime_seconds", "", "gauge", uptime});
+    for (size_t kind = 0; kind < STATEMENT_KINDS; ++kind) {
+        if (latencies[kind].count() != 0)
+            samples.push_back({"db_statements_total", "type=\"" + std::string(kKinds[kind]) + "\"", "counter",
+                               double(latencies[kind].count())});
+    }
+    for (size_t kind = 0; kind < STATEMENT_KINDS; ++kind) {
+        if (latencies[kind].count() != 0)
+            samples.push_back({"db_statements_per_second", "type=\"" + std::string(kKinds[kind]) + "\"", "gauge",
+                               latencies[kind].count() / uptime});
+    }
+    for (size_t kind = 0; kind < STATEMENT_KINDS; ++kind) {
+        const Histogram& latency = latencies[kind];
+        if (latency.count() == 0)
+            continue;
+        std::string type = "type=\"" + std::string(kKinds[kind]) + "\"";
+        for (auto quantile : {"0.5", "0.99", "0.999"}) {
+            samples.push_back({"db_statement_latency_seconds", type + ",quantile=\"" + quantile + "\"", "summary",
+                               latency.Quantile(std::stod(quantile)) / 1e9});
+        }
+        samples.push_back({"db_statement_latency_seconds_sum", type, nullptr, latency.sum() / 1e9});
+        samples.push_back({"db_statement_latency_seconds_count", type, nullptr, double(latency.count())});
+    }
+    for (size_t counter = 0; counter < COUNTERS; ++counter) {
+        samples.push_back({kCounters[counter], "", "counter", double(counters[counter])});
+    }
+
+    return samples;
+}
+
+std::string Metrics::Format(double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+
+    return std::string(buffer, result.ptr);
+}
+
+std::string Metrics::ToPrometheus(const std::vector<MetricSample>& samples) {
+    std::string text;
+    std::string family;
+    for (auto& sample : samples) {
+        if (sample.type != nullptr && sample.name != family) {
+            family = sample.name;
+            text += "# TYPE " + family + " " + sample.type + "\n";
+        }
+        text += sample.name + (sample.labels.empty() ? "" : "{" + sample.labels + "}") + " " + Format(sample.value) +
+                "\n";
+    }
+
+    return text;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DB {
+
+    enum StatementKind {
+        STATEMENT_SELECT,
+        STATEMENT_INSERT,
+        STATEMENT_UPDATE,
+        STATEMENT_DELETE,
+        STATEMENT_DDL,
+        STATEMENT_COPY,
+        STATEMENT_TRANSACTION,
+        STATEMENT_OTHER,
+        STATEMENT_ERROR,
+        STATEMENT_KINDS
+    };
+
+    enum Counter {
+        ROWS_SCANNED,
+        ROWS_RETURNED,
+        COUNTERS
+    };
+
+    struct MetricSample {
+        std::string name;
+        std::string labels;
+        // The Prometheus type of the sample's family; nullptr for the _sum and _count samples of a summary.
+        const char* type;
+        double value;
+    };
+
+    // Values are exact below 16 and fall into 16 buckets per power of two above, so a quantile is off by at most
+    // one bucket width, about 6%.
+    class Histogram {
+    private:
+        static constexpr int kSubBits = 4;
+        static constexpr int kMaxBits = 40;
+
+        std::vector<uint64_t> buckets_;
+        uint64_t sum_ = 0;
+        uint64_t max_ = 0;
+
+    public:
+        static constexpr size_t kBuckets = (kMaxBits - kSubBits + 1) << kSubBits;
+
+        static size_t Bucket(uint64_t value);
+
+        Histogram()
+                : buckets_(kBuckets)
+        {}
+
+        void Add(size_t bucket, uint64_t count);
+
+        void AddSum(uint64_t sum, uint64_t max);
+
+        uint64_t count() const;
+
+        uint64_t sum() const;
+
+        uint64_t Quantile(double quantile) const;
+    };
+
+    // Every thread writes counters and latency buckets into its own shard, so recording takes no lock and no atomic
+    // read-modify-write; Collect merges the shards.
+    class Metrics {
+    private:
+        struct Shard {
+            std::thread::id owner;
+            std::array<std::atomic<uint64_t>, COUNTERS> counters{};
+            std::array<std::array<std::atomic<uint64_t>, Histogram::kBuckets>, STATEMENT_KINDS> latencies{};
+            std::array<std::atomic<uint64_t>, STATEMENT_KINDS> sums{};
+            std::array<std::atomic<uint64_t>, STATEMENT_KINDS> maxima{};
+        };
+
+        uint64_t id_;
+        std::chrono::steady_clock::time_point start_;
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<Shard>> shards_;
+
+        Shard& Local();
+
+        static void Bump(std::atomic<uint64_t>& value, uint64_t delta) {
+            value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
+
+    public:
+        Metrics();
+
+        Metrics(const Metrics&) = delete;
+
+        Metrics& operator=(const Metrics&) = delete;
+
+        void Count(Counter counter, uint64_t value);
+
+        void Record(StatementKind kind, std::chrono::steady_clock::duration latency);
+
+        std::vector<MetricSample> Collect() const;
+
+        // The shortest text that reads back as value.
+        static std::string Format(double value);
+
+        static std::string ToPrometheus(const std::vector<MetricSample>& samples);
+    };
+
+}
@@ -0,0 +1,788 @@
+#include "parser.h"
+
+using namespace DB;
+
+static bool IsWordChar(char c) {
+    return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+}
+
+static bool SameKeyword(std::string_view text, std::string_view keyword) {
+    if (text.size() != keyword.size())
+        return false;
+    for (size_t i = 0; i < keyword.size(); ++i) {
+        if (toupper(static_cast<unsigned char>(text[i])) != keyword[i])
+            return false;
+    }
+
+    return true;
+}
+
+static bool IsNumber(const Token& token) {
+    return token.type == WORD && (isdigit(static_cast<unsigned char>(token.text[0])) || token.text[0] == '.');
+}
+
+Token Lexer::Next() {
+    while (position_ < input_.size() && isspace(static_cast<unsigned char>(input_[position_])))
+        ++position_;
+    Token token;
+    token.position = position_;
+    if (position_ == input_.size())
+        return token;
+    char c = input_[position_];
+    size_t start = position_;
+    if (IsWordChar(c)) {
+        while (position_ < input_.size() && IsWordChar(input_[position_]))
+            ++position_;
+        token.type = WORD;
+    } else if (c == '\'' || c == '"') {
+        ++position_;
+        while (position_ < input_.size() && input_[position_] != c)
+            ++position_;
+        if (position_ == input_.size()) {
+            token.type = BAD;
+        } else {
+            ++position_;
+            token.type = STRING;
+        }
+    } else {
+        ++position_;
+        token.type = SYMBOL;
+        if (position_ < input_.size()) {
+            char next = input_[position_];
+            if ((c == '<' && (next == '=' || next == '>')) || ((c == '>' || c == '!') && next == '='))
+                ++position_;
+        }
+        if (c == '!' && position_ - start == 1)
+            token.type = BAD;
+        else if (std::string_view("(),;*=<>!-+?").find(c) == std::string_view::npos)
+            token.type = BAD;
+    }
+    token.text = input_.substr(start, position_ - start);
+
+    return token;
+}
+
+void Parser::Advance() {
+    current_ = lexer_.Next();
+}
+
+bool Parser::IsKeyword(std::string_view keyword) const {
+    return current_.type == WORD && SameKeyword(current_.text, keyword);
+}
+
+bool Parser::IsSymbol(std::string_view symbol) const {
+    return current_.type == SYMBOL && current_.text == symbol;
+}
+
+bool Parser::AcceptSymbol(std::string_view symbol) {
+    if (!IsSymbol(symbol))
+        return false;
+    Advance();
+
+    return true;
+}
+
+bool Parser::Fail(const std::string& expected) {
+    if (!error_.empty())
+        return false;
+    std::string found;
+    if (current_.type == END)
+        found = "END OF INPUT";
+    else
+        found = "\"" + std::string(current_.text) + "\"";
+    error_ = "-- SYNTAX ERROR AT POSITION " + std::to_string(current_.position + 1) + ": EXPECTED " + expected +
+             ", FOUND " + found + " --\n";
+
+    return false;
+}
+
+bool Parser::ExpectKeyword(std::string_view keyword) {
+    if (!IsKeyword(keyword))
+        return Fail(std::string(keyword));
+    Advance();
+
+    return true;
+}
+
+bool Parser::ExpectSymbol(std::string_view symbol) {
+    if (!IsSymbol(symbol))
+        return Fail("\"" + std::string(symbol) + "\"");
+    Advance();
+
+    return true;
+}
+
+bool Parser::ParseName(std::string& name) {
+    if (current_.type != WORD || !(isalpha(static_cast<unsigned char>(current_.text[0])) || current_.text[0] == '_') ||
+        current_.text.find('.') != std::string_view::npos)
+        return Fail("NAME");
+    name = current_.text;
+    Advance();
+
+    return true;
+}
+
+bool Parser::ParseColumnName(std::string& name) {
+    if (current_.type != WORD || !(isalpha(static_cast<unsigned char>(current_.text[0])) || current_.text[0] == '_'))
+        return Fail("COLUMN NAME");
+    name = current_.text;
+    Advance();
+
+    return true;
+}
+
+bool Parser::ParseValue(std::string& value) {
+    if (IsSymbol("?")) {
+        value = std::string(1, '\0') + std::to_string(parameters_++);
+        Advance();
+        return true;
+    }
+    std::string sign;
+    if (IsSymbol("-") || IsSymbol("+")) {
+        sign = current_.text;
+        Advance();
+        if (current_.type != WORD)
+            return Fail("NUMBER");
+    }
+    if (current_.type == WORD) {
+        value = sign + std::string(current_.text);
+    } else if (current_.type == STRING) {
+        value = current_.text.substr(1, current_.text.size() - 2);
+    } else {
+        return Fail("VALUE");
+    }
+    Advance();
+
+    return true;
+}
+
+bool Parser::IsAggregate() const {
+    Lexer lookahead = lexer_;
+
+    return (IsKeyword("COUNT") || IsKeyword("SUM") || IsKeyword("AVG") || IsKeyword("MIN") || IsKeyword("MAX")) &&
+           lookahead.Next().text == "(";
+}
+
+bool Parser::ParseAggregate(Aggregate& aggregate) {
+    aggregate.function = IsKeyword("COUNT") ? AGGREGATE_COUNT
+                       : IsKeyword("SUM")   ? AGGREGATE_SUM
+                       : IsKeyword("AVG")   ? AGGREGATE_AVG
+                       : IsKeyword("MIN")   ? AGGREGATE_MIN
+                                            : AGGREGATE_MAX;
+    Advance();
+    if (!ExpectSymbol("("))
+        return false;
+    if (aggregate.function == AGGREGATE_COUNT && IsSymbol("*")) {
+        aggregate.column = "*";
+        Advance();
+    } else if (!ParseColumnName(aggregate.column)) {
+        return false;
+    }
+
+    return ExpectSymbol(")");
+}
+
+bool Parser::ParseOperand(std::string& operand) {
+    if (current_.type == STRING) {
+        operand = "\"" + std::string(current_.text.substr(1, current_.text.size() - 2)) + "\"";
+        Advance();
+        return true;
+    }
+    if (aggregates_ != nullptr && IsAggregate()) {
+        auto& aggregate = aggregates_->emplace_back();
+        if (!ParseAggregate(aggregate))
+            return false;
+        operand = aggregate.Name();
+        return true;
+    }
+
+    return ParseValue(operand);
+}
+
+bool Parser::ParseComparison(Expression& expression) {
+    std::string lhs;
+    std::string rhs;
+    if (!ParseOperand(lhs))
+        return false;
+    if (!(IsSymbol("=") || IsSymbol("!=") || IsSymbol("<>") || IsSymbol("<") || IsSymbol("<=") ||
+          IsSymbol(">") || IsSymbol(">=")))
+        return Fail("COMPARISON OPERATOR");
+    std::string symbol = IsSymbol("<>") ? "!=" : std::string(current_.text);
+    Advance();
+    if (!ParseOperand(rhs))
+        return false;
+    expression.type = COMPARISON;
+    expression.condition = Condition(symbol, lhs, rhs);
+
+    return true;
+}
+
+bool Parser::ParsePrimary(Expression& expression) {
+    if (IsSymbol("(")) {
+        Advance();
+        if (!ParseOr(expression))
+            return false;
+        return ExpectSymbol(")");
+    }
+
+    return ParseComparison(expression);
+}
+
+bool Parser::ParseAnd(Expression& expression) {
+    if (!ParsePrimary(expression))
+        return false;
+    if (!IsKeyword("AND"))
+        return true;
+    Expression result;
+    result.type = AND;
+    result.children.emplace_back(std::move(expression));
+    while (IsKeyword("AND")) {
+        Advance();
+        result.children.emplace_back();
+        if (!ParsePrimary(result.children.back()))
+            return false;
+    }
+    expression = std::move(result);
+
+    return true;
+}
+
+bool Parser::ParseOr(Expression& expression) {
+    if (!ParseAnd(expression))
+        return false;
+    if (!IsKeyword("OR"))
+        return true;
+    Expression result;
+    result.type = OR;
+    result.children.emplace_back(std::move(expression));
+    while (IsKeyword("OR")) {
+        Advance();
+        result.children.emplace_back();
+        if (!ParseAnd(result.children.back()))
+            return false;
+    }
+    expression = std::move(result);
+
+    return true;
+}
+
+bool Parser::ParseCreateIndex(Statement& statement) {
+    statement.type = CREATE_INDEX;
+    statement.columns.emplace_back();
+
+    return ParseName(statement.index) && ExpectKeyword("ON") && ParseName(statement.table) && ExpectSymbol("(") &&
+           ParseName(statement.columns.back()) && ExpectSymbol(")");
+}
+
+bool Parser::ParseCreate(Statement& statement) {
+    if (IsKeyword("INDEX")) {
+        Advance();
+        return ParseCreateIndex(statement);
+    }
+    statement.type = CREATE_TABLE;
+    if (!ExpectKeyword("TABLE") || !ParseName(statement.table) || !ExpectSymbol("("))
+        return false;
+    do {
+        if (IsKeyword("PRIMARY")) {
+            Advance();
+            if (!ExpectKeyword("KEY") || !ExpectSymbol("(") || !ParseName(statement.primary_key) ||
+                !ExpectSymbol(")"))
+                return false;
+            break;
+        }
+        std::string name;
+        std::string type;
+        if (!ParseName(name) || !ParseName(type))
+            return false;
+        statement.definitions.emplace_back(name, type);
+    } while (AcceptSymbol(","));
+
+    return ExpectSymbol(")");
+}
+
+bool Parser::ParseDrop(Statement& statement) {
+    if (IsKeyword("INDEX")) {
+        Advance();
+        statement.type = DROP_INDEX;
+        return ParseName(statement.index);
+    }
+    statement.type = DROP_TABLE;
+
+    return ExpectKeyword("TABLE") && ParseName(statement.table);
+}
+
+bool Parser::ParseSelect(Statement& statement) {
+    statement.type = SELECT;
+    if (IsSymbol("*")) {
+        statement.columns.emplace_back("*");
+        Advance();
+    } else {
+        do {
+            auto& aggregate = statement.aggregates.emplace_back();
+            if (IsAggregate()) {
+                statement.has_group = true;
+                if (!ParseAggregate(aggregate))
+                    return false;
+            } else if (!ParseColumnName(aggregate.column)) {
+                return false;
+            }
+            statement.columns.emplace_back(aggregate.Name());
+        } while (AcceptSymbol(","));
+    }
+    if (!ExpectKeyword("FROM") || !ParseName(statement.table))
+        return false;
+    if (IsKeyword("INNER") || IsKeyword("LEFT") || IsKeyword("RIGHT")) {
+        statement.has_join = true;
+        statement.join.type = IsKeyword("INNER") ? "INNER" : IsKeyword("LEFT") ? "LEFT" : "RIGHT";
+        Advance();
+        if (!ExpectKeyword("JOIN") || !ParseName(statement.join.table) || !ExpectKeyword("ON") ||
+            !ParseOr(statement.join.on))
+            return false;
+    }
+    if (IsKeyword("WHERE")) {
+        Advance();
+        statement.has_where = true;
+        if (!ParseOr(statement.where))
+            return false;
+    }
+    if (IsKeyword("GROUP")) {
+        Advance();
+        statement.has_group = true;
+        if (!ExpectKeyword("BY"))
+            return false;
+        do {
+            statement.group_by.emplace_back();
+            if (!ParseColumnName(statement.group_by.back()))
+                return false;
+        } while (AcceptSymbol(","));
+    }
+    if (IsKeyword("HAVING")) {
+        Advance();
+        statement.has_group = true;
+        statement.has_having = true;
+        aggregates_ = &statement.aggregates;
+        bool result = ParseOr(statement.having);
+        aggregates_ = nullptr;
+        if (!result)
+            return false;
+    }
+    if (IsKeyword("ORDER")) {
+        Advance();
+        if (!ExpectKeyword("BY"))
+            return false;
+        do {
+            auto& order = statement.order_by.emplace_back();
+            if (IsAggregate()) {
+                statement.has_group = true;
+                auto& aggregate = statement.aggregates.emplace_back();
+                if (!ParseAggregate(aggregate))
+                    return false;
+                order.column = aggregate.Name();
+            } else if (!ParseColumnName(order.column)) {
+                return false;
+            }
+            if (IsKeyword("ASC") || IsKeyword("DESC")) {
+                order.descending = IsKeyword("DESC");
+                Advance();
+            }
+        } while (AcceptSymbol(","));
+    }
+    if (IsKeyword("LIMIT")) {
+        Advance();
+        if (!ParseValue(statement.limit))
+            return false;
+    }
+    if (IsKeyword("OFFSET")) {
+        Advance();
+        return ParseValue(statement.offset);
+    }
+
+    return true;
+}
+
+bool Parser::ParseInsert(Statement& statement) {
+    statement.type = INSERT;
+    if (!ExpectKeyword("INTO") || !ParseName(statement.table))
+        return false;
+    if (IsSymbol("(")) {
+        Advance();
+        do {
+            statement.columns.emplace_back();
+            if (!ParseName(statement.columns.back()))
+                return false;
+        } while (AcceptSymbol(","));
+        if (!ExpectSymbol(")"))
+            return false;
+    }
+    if (!ExpectKeyword("VALUES"))
+        return false;
+    do {
+        if (!ExpectSymbol("("))
+            return false;
+        auto& values = statement.values.emplace_back();
+        do {
+            values.emplace_back();
+            if (!ParseValue(values.back()))
+                return false;
+        } while (AcceptSymbol(","));
+        if (!ExpectSymbol(")"))
+            return false;
+    } while (AcceptSymbol(","));
+
+    return true;
+}
+
+bool Parser::ParseDelete(Statement& statement) {
+    statement.type = DELETE;
+    if (!ExpectKeyword("FROM") || !ParseName(statement.table) || !ExpectKeyword("WHERE"))
+        return false;
+    statement.has_where = true;
+
+    return ParseOr(statement.where);
+}
+
+bool Parser::ParseUpdate(Statement& statement) {
+    statement.type = UPDATE;
+    if (!ParseName(statement.table) || !ExpectKeyword("SET"))
+        return false;
+    do {
+        std::string name;
+        std::string value;
+        if (!ParseName(name) || !ExpectSymbol("=") || !ParseValue(value))
+            return false;
+        statement.assignments.emplace_back(name, value);
+    } while (AcceptSymbol(","));
+    if (!ExpectKeyword("WHERE"))
+        return false;
+    statement.has_where = true;
+
+    return ParseOr(statement.where);
+}
+
+bool Parser::ParseCopy(Statement& statement) {
+    statement.type = COPY;
+    if (!ParseName(statement.table))
+        return false;
+    if (IsSymbol("(")) {
+        Advance();
+        do {
+            statement.columns.emplace_back();
+            if (!ParseName(statement.columns.back()))
+                return false;
+        } while (AcceptSymbol(","));
+        if (!ExpectSymbol(")"))
+            return false;
+    }
+    if (!ExpectKeyword("FROM"))
+        return false;
+    if (current_.type != STRING)
+        return Fail("FILE PATH");
+    statement.path = current_.text.substr(1, current_.text.size() - 2);
+    Advance();
+    if (!IsKeyword("WITH"))
+        return true;
+    Advance();
+    if (!ExpectSymbol("("))
+        return false;
+    do {
+        if (IsKeyword("HEADER")) {
+            Advance();
+            statement.header = true;
+        } else if (IsKeyword("DELIMITER")) {
+            Advance();
+            if (current_.type != STRING || current_.text.size() != 3)
+                return Fail("SINGLE CHARACTER");
+            statement.delimiter = current_.text[1];
+            Advance();
+        } else {
+            return Fail("COPY OPTION");
+        }
+    } while (AcceptSymbol(","));
+
+    return ExpectSymbol(")");
+}
+
+bool Parser::ParsePrepare(Statement& statement) {
+    statement.type = PREPARE;
+    if (!ParseName(statement.name) || !ExpectKeyword("AS"))
+        return false;
+    if (IsKeyword("PREPARE") || IsKeyword("EXECUTE") || IsKeyword("DEALLOCATE"))
+        return Fail("STATEMENT");
+    statement.prepared = std::make_shared<Statement>();
+    if (!ParseStatement(*statement.prepared))
+        return false;
+    statement.prepared->parameters = parameters_;
+    parameters_ = 0;
+
+    return true;
+}
+
+bool Parser::ParseExecute(Statement& statement) {
+    statement.type = EXECUTE;
+    if (!ParseName(statement.name))
+        return false;
+    auto& values = statement.values.emplace_back();
+    if (!AcceptSymbol("("))
+        return true;
+    do {
+        values.emplace_back();
+        if (!ParseValue(values.back()))
+            return false;
+    } while (AcceptSymbol(","));
+
+    return ExpectSymbol(")");
+}
+
+bool Parser::ParseExplain(Statement& statement) {
+    statement.type = EXPLAIN;
+    if (IsKeyword("ANALYZE")) {
+        Advance();
+        statement.analyze = true;
+    }
+    if (IsKeyword("EXPLAIN") || IsKeyword("PREPARE") || IsKeyword("DEALLOCATE"))
+        return Fail("STATEMENT");
+    size_t start = current_.position;
+    statement.prepared = std::make_shared<Statement>();
+    if (!ParseStatement(*statement.prepared))
+        return false;
+    statement.text = std::string(input_.substr(start, current_.position - start)) + ";";
+    statement.prepared->parameters = parameters_;
+    parameters_ = 0;
+
+    return true;
+}
+
+bool Parser::ParseShow(Statement& statement) {
+    statement.type = SHOW_STATS;
+    if (!ExpectKeyword("STATS"))
+        return false;
+    if (!IsKeyword("TO"))
+        return true;
+    Advance();
+    if (current_.type != STRING)
+        return Fail("FILE PATH");
+    statement.path = current_.text.substr(1, current_.text.size() - 2);
+    Advance();
+
+    return true;
+}
+
+bool Parser::ParseStatement(Statement& statement) {
+    bool result;
+    if (IsKeyword("CREATE")) {
+        Advance();
+        result = ParseCreate(statement);
+    } else if (IsKeyword("DROP")) {
+        Advance();
+        result = ParseDrop(statement);
+    } else if (IsKeyword("SELECT")) {
+        Advance();
+        result = ParseSelect(statement);
+    } else if (IsKeyword("INSERT")) {
+        Advance();
+        result = ParseInsert(statement);
+    } else if (IsKeyword("DELETE")) {
+        Advance();
+        result = ParseDelete(statement);
+    } else if (IsKeyword("UPDATE")) {
+        Advance();
+        result = ParseUpdate(statement);
+    } else if (IsKeyword("VACUUM")) {
+        Advance();
+        statement.type = VACUUM;
+        result = ParseName(statement.table);
+    } else if (IsKeyword("COPY")) {
+        Advance();
+        result = ParseCopy(statement);
+    } else if (IsKeyword("CHECKPOINT")) {
+        Advance();
+        statement.type = CHECKPOINT;
+        result = true;
+    } else if (IsKeyword("BEGIN")) {
+        Advance();
+        statement.type = BEGIN;
+        if (IsKeyword("TRANSACTION"))
+            Advance();
+        result = true;
+    } else if (IsKeyword("COMMIT")) {
+        Advance();
+        statement.type = COMMIT;
+        result = true;
+    } else if (IsKeyword("ROLLBACK")) {
+        Advance();
+        statement.type = ROLLBACK;
+        result = true;
+    } else if (IsKeyword("PREPARE")) {
+        Advance();
+        result = ParsePrepare(statement);
+    } else if (IsKeyword("EXECUTE")) {
+        Advance();
+        result = ParseExecute(statement);
+    } else if (IsKeyword("DEALLOCATE")) {
+        Advance();
+        if (IsKeyword("PREPARE"))
+            Advance();
+        statement.type = DEALLOCATE;
+        result = ParseName(statement.name);
+    } else if (IsKeyword("EXPLAIN")) {
+        Advance();
+        result = ParseExplain(statement);
+    } else if (IsKeyword("SHOW")) {
+        Advance();
+        result = ParseShow(statement);
+    } else {
+        return Fail("STATEMENT");
+    }
+
+    return result;
+}
+
+bool Parser::Parse(Statement& statement) {
+    if (!ParseStatement(statement) || !ExpectSymbol(";"))
+        return false;
+    statement.parameters = parameters_;
+
+    return true;
+}
+
+const std::string& Parser::error() const {
+    return error_;
+}
+
+std::vector<std::vector<Condition>> Parser::ToDNF(const Expression& expression) {
+    if (expression.type == COMPARISON)
+        return {{expression.condition}};
+    std::vector<std::vector<Condition>> result;
+    if (expression.type == OR) {
+        for (auto& child : expression.children) {
+            for (auto& conjunction : ToDNF(child)) {
+                result.emplace_back(std::move(conjunction));
+            }
+        }
+        return result;
+    }
+    result = {{}};
+    for (auto& child : expression.children) {
+        auto child_result = ToDNF(child);
+        std::vector<std::vector<Condition>> product;
+        for (auto& lhs : result) {
+            for (auto& rhs : child_result) {
+                product.emplace_back(lhs);
+                product.back().insert(product.back().end(), rhs.begin(), rhs.end());
+            }
+        }
+        result = std::move(product);
+    }
+
+    return result;
+}
+
+bool Parser::IsParameter(const std::string& value, size_t& parameter) {
+    if (value.size() < 2 || value[0] != '\0')
+        return false;
+    parameter = std::stoul(value.substr(1));
+
+    return true;
+}
+
+void Parser::AddSlots(std::vector<std::vector<Condition>>& conditions, SlotType type, std::vector<Slot>& slots) {
+    size_t parameter;
+    for (size_t i = 0; i < conditions.size(); ++i) {
+        for (size_t j = 0; j < conditions[i].size(); ++j) {
+            if (IsParameter(conditions[i][j].lhs(), parameter))
+                slots.push_back({type, i, j, true, parameter});
+            if (IsParameter(conditions[i][j].rhs(), parameter))
+                slots.push_back({type, i, j, false, parameter});
+        }
+    }
+}
+
+Plan Parser::Compile(Statement statement) {
+    Plan plan;
+    if (statement.has_where)
+        plan.where = ToDNF(statement.where);
+    if (statement.has_join)
+        plan.on = ToDNF(statement.join.on);
+    if (statement.has_having)
+        plan.having = ToDNF(statement.having);
+    size_t parameter;
+    for (size_t i = 0; i < statement.values.size(); ++i) {
+        for (size_t j = 0; j < statement.values[i].size(); ++j) {
+            if (IsParameter(statement.values[i][j], parameter))
+                plan.slots.push_back({SLOT_VALUE, i, j, false, parameter});
+        }
+    }
+    for (size_t i = 0; i < statement.assignments.size(); ++i) {
+        if (IsParameter(statement.assignments[i].second, parameter))
+            plan.slots.push_back({SLOT_ASSIGNMENT, i, 0, false, parameter});
+    }
+    if (IsParameter(statement.limit, parameter))
+        plan.slots.push_back({SLOT_LIMIT, 0, 0, false, parameter});
+    if (IsParameter(statement.offset, parameter))
+        plan.slots.push_back({SLOT_OFFSET, 0, 0, false, parameter});
+    AddSlots(plan.where, SLOT_WHERE, plan.slots);
+    AddSlots(plan.on, SLOT_ON, plan.slots);
+    AddSlots(plan.having, SLOT_HAVING, plan.slots);
+    plan.statement = std::move(statement);
+
+    return plan;
+}
+
+bool Parser::Bind(Plan& plan, const std::vector<std::string>& values) {
+    if (values.size() != plan.statement.parameters)
+        return false;
+    for (auto& slot : plan.slots) {
+        const std::string& value = values[slot.parameter];
+        if (slot.type == SLOT_VALUE) {
+            plan.statement.values[slot.row][slot.column] = value;
+        } else if (slot.type == SLOT_ASSIGNMENT) {
+            plan.statement.assignments[slot.row].second = value;
+        } else if (slot.type == SLOT_LIMIT) {
+            plan.statement.limit = value;
+        } else if (slot.type == SLOT_OFFSET) {
+            plan.statement.offset = value;
+        } else {
+            auto& conditions = slot.type == SLOT_WHERE ? plan.where : slot.type == SLOT_ON ? plan.on : plan.having;
+            auto& condition = conditions[slot.row][slot.column];
+            std::string quoted = "\"" + value + "\"";
+            condition = slot.lhs ? Condition(condition.symbol(), quoted, condition.rhs())
+                                 : Condition(condition.symbol(), condition.lhs(), quoted);
+        }
+    }
+
+    return true;
+}
+
+std::string Parser::Normalize(std::string_view input, std::vector<std::string>& literals) {
+    std::vector<Token> tokens;
+    Lexer lexer(input);
+    for (Token token = lexer.Next(); token.type != END; token = lexer.Next()) {
+        if (token.type == BAD)
+            return "";
+        tokens.push_back(token);
+    }
+    if (tokens.empty() || !(SameKeyword(tokens[0].text, "SELECT") || SameKeyword(tokens[0].text, "INSERT") ||
+                            SameKeyword(tokens[0].text, "UPDATE") || SameKeyword(tokens[0].text, "DELETE")))
+        return "";
+    std::string key;
+    key.reserve(input.size() + tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        auto& token = tokens[i];
+        bool sign = token.type == SYMBOL && (token.text == "-" || token.text == "+");
+        if (token.type == STRING) {
+            literals.emplace_back(token.text.substr(1, token.text.size() - 2));
+            key += '?';
+        } else if (sign && i + 1 < tokens.size() && IsNumber(tokens[i + 1])) {
+            literals.emplace_back(std::string(token.text) + std::string(tokens[++i].text));
+            key += '?';
+        } else if (IsNumber(token)) {
+            literals.emplace_back(token.text);
+            key += '?';
+        } else {
+            key += token.text;
+        }
+        key += ' ';
+    }
+
+    return key;
+}
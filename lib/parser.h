@@ -0,0 +1,231 @@
+#pragma once
+
+#include "database.h"
+
+#include <string_view>
+
+namespace DB {
+
+    enum TokenType {
+        WORD,
+        STRING,
+        SYMBOL,
+        END,
+        BAD
+    };
+
+    struct Token {
+        TokenType type = END;
+        std::string_view text;
+        size_t position = 0;
+    };
+
+    class Lexer {
+    private:
+        std::string_view input_;
+        size_t position_ = 0;
+
+    public:
+        explicit Lexer(std::string_view input)
+                : input_(input)
+        {}
+
+        Token Next();
+    };
+
+    enum StatementType {
+        CREATE_TABLE,
+        DROP_TABLE,
+        CREATE_INDEX,
+        DROP_INDEX,
+        SELECT,
+        INSERT,
+        DELETE,
+        UPDATE,
+        VACUUM,
+        CHECKPOINT,
+        COPY,
+        BEGIN,
+        COMMIT,
+        ROLLBACK,
+        PREPARE,
+        EXECUTE,
+        DEALLOCATE,
+        EXPLAIN,
+        SHOW_STATS
+    };
+
+    enum ExpressionType {
+        COMPARISON,
+        AND,
+        OR
+    };
+
+    struct Expression {
+        ExpressionType type = COMPARISON;
+        Condition condition;
+        std::vector<Expression> children;
+    };
+
+    struct Join {
+        std::string type;
+        std::string table;
+        Expression on;
+    };
+
+    struct Statement {
+        StatementType type = SELECT;
+        std::string table;
+        std::string index;
+        std::vector<std::pair<std::string, std::string>> definitions;
+        std::string primary_key;
+        std::vector<std::string> columns;
+        std::vector<std::vector<std::string>> values;
+        std::vector<std::pair<std::string, std::string>> assignments;
+        bool has_join = false;
+        Join join;
+        bool has_where = false;
+        Expression where;
+        bool has_group = false;
+        std::vector<Aggregate> aggregates;
+        std::vector<std::string> group_by;
+        bool has_having = false;
+        Expression having;
+        std::vector<OrderBy> order_by;
+        std::string limit;
+        std::string offset;
+        std::string path;
+        char delimiter = ',';
+        bool header = false;
+        std::string name;
+        std::shared_ptr<Statement> prepared;
+        size_t parameters = 0;
+        bool analyze = false;
+        std::string text;
+    };
+
+    enum SlotType {
+        SLOT_VALUE,
+        SLOT_ASSIGNMENT,
+        SLOT_WHERE,
+        SLOT_ON,
+        SLOT_HAVING,
+        SLOT_LIMIT,
+        SLOT_OFFSET
+    };
+
+    struct Slot {
+        SlotType type;
+        size_t row;
+        size_t column;
+        bool lhs;
+        size_t parameter;
+    };
+
+    // A statement with its conditions already in disjunctive normal form. Each slot is one place a ? was written;
+    // ToDNF can copy a condition, so a parameter may fill several slots.
+    struct Plan {
+        Statement statement;
+        std::vector<std::vector<Condition>> where;
+        std::vector<std::vector<Condition>> on;
+        std::vector<std::vector<Condition>> having;
+        std::vector<Slot> slots;
+    };
+
+    class Parser {
+    private:
+        Lexer lexer_;
+        std::string_view input_;
+        Token current_;
+        std::string error_;
+        size_t parameters_ = 0;
+        std::vector<Aggregate>* aggregates_ = nullptr;
+
+        void Advance();
+
+        bool IsKeyword(std::string_view keyword) const;
+
+        bool IsSymbol(std::string_view symbol) const;
+
+        bool AcceptSymbol(std::string_view symbol);
+
+        bool Fail(const std::string& expected);
+
+        bool ExpectKeyword(std::string_view keyword);
+
+        bool ExpectSymbol(std::string_view symbol);
+
+        bool ParseName(std::string& name);
+
+        bool ParseColumnName(std::string& name);
+
+        bool ParseValue(std::string& value);
+
+        bool IsAggregate() const;
+
+        bool ParseAggregate(Aggregate& aggregate);
+
+        bool ParseOperand(std::string& operand);
+
+        bool ParseComparison(Expression& expression);
+
+        bool ParsePrimary(Expression& expression);
+
+        bool ParseAnd(Expression& expression);
+
+        bool ParseOr(Expression& expression);
+
+        bool ParseCreate(Statement& statement);
+
+        bool ParseCreateIndex(Statement& statement);
+
+        bool ParseDrop(Statement& statement);
+
+        bool ParseSelect(Statement& statement);
+
+        bool ParseInsert(Statement& statement);
+
+        bool ParseDelete(Statement& statement);
+
+        bool ParseUpdate(Statement& statement);
+
+        bool ParseCopy(Statement& statement);
+
+        bool ParsePrepare(Statement& statement);
+
+        bool ParseExecute(Statement& statement);
+
+        bool ParseExplain(Statement& statement);
+
+        bool ParseShow(Statement& statement);
+
+        bool ParseStatement(Statement& statement);
+
+        static bool IsParameter(const std::string& value, size_t& parameter);
+
+        static void AddSlots(std::vector<std::vector<Condition>>& conditions, SlotType type, std::vector<Slot>& slots);
+
+    public:
+        explicit Parser(std::string_view input)
+                : lexer_(input)
+                , input_(input)
+        {
+            Advance();
+        }
+
+        bool Parse(Statement& statement);
+
+        const std::string& error() const;
+
+        static std::vector<std::vector<Condition>> ToDNF(const Expression& expression);
+
+        static Plan Compile(Statement statement);
+
+        static bool Bind(Plan& plan, const std::vector<std::string>& values);
+
+        // Replaces the numbers and quoted strings of a SELECT, INSERT, UPDATE or DELETE with ? and returns the
+        // text, which keys the statement cache; empty for other statements.
+        static std::string Normalize(std::string_view input, std::vector<std::string>& literals);
+    };
+
+}
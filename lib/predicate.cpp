@@ -0,0 +1,461 @@
+#include "predicate.h"
+#include "arena.h"
+
+#include <algorithm>
+#include <functional>
+
+using namespace DB;
+
+template <typename T>
+static bool Fetch(const Operand& operand, const size_t* rows, T& value);
+
+template <>
+bool Fetch<int64_t>(const Operand& operand, const size_t* rows, int64_t& value) {
+    if (operand.column == nullptr) {
+        value = operand.int_value;
+        return true;
+    }
+    size_t row = rows[operand.slot];
+    if (operand.column->IsNull(row))
+        return false;
+    value = operand.column->GetInt(row);
+
+    return true;
+}
+
+template <>
+bool Fetch<double>(const Operand& operand, const size_t* rows, double& value) {
+    if (operand.column == nullptr) {
+        value = operand.double_value;
+        return true;
+    }
+    size_t row = rows[operand.slot];
+    if (operand.column->IsNull(row))
+        return false;
+    if (operand.column->type() == INT)
+        value = operand.column->GetInt(row);
+    else
+        value = operand.column->GetDouble(row);
+
+    return true;
+}
+
+template <>
+bool Fetch<bool>(const Operand& operand, const size_t* rows, bool& value) {
+    if (operand.column == nullptr) {
+        value = operand.bool_value;
+        return true;
+    }
+    size_t row = rows[operand.slot];
+    if (operand.column->IsNull(row))
+        return false;
+    value = operand.column->GetBool(row);
+
+    return true;
+}
+
+template <>
+bool Fetch<std::string_view>(const Operand& operand, const size_t* rows, std::string_view& value) {
+    if (operand.column == nullptr) {
+        value = operand.text_value;
+        return true;
+    }
+    size_t row = rows[operand.slot];
+    if (operand.column->IsNull(row))
+        return false;
+    value = operand.column->GetText(row);
+
+    return true;
+}
+
+template <>
+bool Fetch<std::string>(const Operand& operand, const size_t* rows, std::string& value) {
+    if (operand.column == nullptr) {
+        value = operand.text_value;
+        return true;
+    }
+    size_t row = rows[operand.slot];
+    if (operand.column->IsNull(row))
+        return false;
+    value = operand.column->ToString(row);
+
+    return true;
+}
+
+template <typename T, typename Op>
+static bool Compare(const Operand& lhs, const Operand& rhs, const size_t* rows) {
+    T lhs_value;
+    T rhs_value;
+    if (!Fetch<T>(lhs, rows, lhs_value) || !Fetch<T>(rhs, rows, rhs_value))
+        return false;
+
+    return Op()(lhs_value, rhs_value);
+}
+
+static bool Never(const Operand&, const Operand&, const size_t*) {
+    return false;
+}
+
+// Compares a dictionary-encoded column with a constant by code, without touching the text.
+template <typename Op>
+static bool MatchCode(const Operand& lhs, const Operand& rhs, const size_t* rows) {
+    const Operand& column = lhs.column != nullptr ? lhs : rhs;
+    const Operand& constant = lhs.column != nullptr ? rhs : lhs;
+    size_t row = rows[column.slot];
+
+    return !column.column->IsNull(row) && Op()(column.column->codes()[row], constant.code);
+}
+
+template <typename T>
+static Comparator ChooseFor(Operators op) {
+    switch (op) {
+        case LESS:
+            return &Compare<T, std::less<>>;
+        case LESS_EQUAL:
+            return &Compare<T, std::less_equal<>>;
+        case GREATER:
+            return &Compare<T, std::greater<>>;
+        case GREATER_EQUAL:
+            return &Compare<T, std::greater_equal<>>;
+        case EQUAL:
+            return &Compare<T, std::equal_to<>>;
+        case NOT_EQUAL:
+            return &Compare<T, std::not_equal_to<>>;
+    }
+
+    return &Never;
+}
+
+Operators Predicate::SeeOperator(const std::string& symbol) {
+    if (symbol == "<")
+        return LESS;
+    else if (symbol == "<=")
+        return LESS_EQUAL;
+    else if (symbol == ">")
+        return GREATER;
+    else if (symbol == ">=")
+        return GREATER_EQUAL;
+    else if (symbol == "=")
+        return EQUAL;
+    return NOT_EQUAL;
+}
+
+Operators Predicate::Flip(Operators op) {
+    if (op == LESS)
+        return GREATER;
+    else if (op == LESS_EQUAL)
+        return GREATER_EQUAL;
+    else if (op == GREATER)
+        return LESS;
+    else if (op == GREATER_EQUAL)
+        return LESS_EQUAL;
+    return op;
+}
+
+Operand Predicate::Resolve(const std::string& value, const std::vector<std::pair<std::string, Table*>>& tables) {
+    Operand operand;
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+        operand.text_value = value.substr(1, value.size() - 2);
+        return operand;
+    }
+    operand.text_value = value;
+    if (value.empty() || !(isalpha(static_cast<unsigned char>(value[0])) || value[0] == '_'))
+        return operand;
+    std::string name = value;
+    size_t dot = value.find('.');
+    if (dot != std::string::npos) {
+        std::string qualifier = value.substr(0, dot);
+        name = value.substr(dot + 1);
+        for (size_t i = 0; i < tables.size(); ++i) {
+            if (tables[i].first != qualifier)
+                continue;
+            if (tables[i].second->IsColumnName(name)) {
+                operand.slot = i;
+                operand.column = &tables[i].second->GetColumn(name);
+            }
+            return operand;
+        }
+    }
+    for (size_t i = 0; i < tables.size(); ++i) {
+        if (tables[i].second->IsColumnName(name)) {
+            operand.slot = i;
+            operand.column = &tables[i].second->GetColumn(name);
+            break;
+        }
+    }
+
+    return operand;
+}
+
+bool Predicate::Bind(Operand& operand, Types type) {
+    if (operand.column != nullptr || type == TEXT || type == UNKNOWN)
+        return true;
+    if (!Column::IsValid(type, operand.text_value))
+        return false;
+    if (type == INT)
+        operand.int_value = std::stoll(operand.text_value);
+    else if (type == DOUBLE)
+        operand.double_value = std::stod(operand.text_value);
+    else if (type == BOOL)
+        operand.bool_value = operand.text_value == "1" || operand.text_value == "TRUE" ||
+                             operand.text_value == "true";
+
+    return true;
+}
+
+Comparator Predicate::Choose(Types type, Operators op) {
+    if (type == INT)
+        return ChooseFor<int64_t>(op);
+    else if (type == DOUBLE)
+        return ChooseFor<double>(op);
+    else if (type == BOOL)
+        return ChooseFor<bool>(op);
+    else if (type == TEXT)
+        return ChooseFor<std::string_view>(op);
+
+    return ChooseFor<std::string>(op);
+}
+
+Predicate::Predicate(const std::vector<std::vector<Condition>>& conditions,
+                     const std::vector<std::pair<std::string, Table*>>& tables) {
+    for (auto& AND_separated : conditions) {
+        std::vector<Comparison> conjunction;
+        for (auto& condition : AND_separated) {
+            Comparison comparison;
+            comparison.lhs = Resolve(condition.lhs(), tables);
+            comparison.rhs = Resolve(condition.rhs(), tables);
+            const Column* lhs = comparison.lhs.column;
+            const Column* rhs = comparison.rhs.column;
+            Types type = TEXT;
+            if (lhs != nullptr && rhs != nullptr) {
+                type = lhs->type();
+                if (lhs->type() != rhs->type()) {
+                    bool numeric = (lhs->type() == INT || lhs->type() == DOUBLE) &&
+                                   (rhs->type() == INT || rhs->type() == DOUBLE);
+                    type = numeric ? DOUBLE : UNKNOWN;
+                }
+            } else if (lhs != nullptr || rhs != nullptr) {
+                type = lhs != nullptr ? lhs->type() : rhs->type();
+                const std::string& constant = lhs != nullptr ? comparison.rhs.text_value : comparison.lhs.text_value;
+                if (type == INT && !Column::IsValid(INT, constant) && Column::IsValid(DOUBLE, constant))
+                    type = DOUBLE;
+            }
+            if (type == UNKNOWN && (lhs == nullptr || lhs->type() == UNKNOWN) &&
+                (rhs == nullptr || rhs->type() == UNKNOWN))
+                type = TEXT;
+            comparison.op = SeeOperator(condition.symbol());
+            comparison.type = type;
+            if (Bind(comparison.lhs, type) && Bind(comparison.rhs, type))
+                comparison.comparator = Choose(type, comparison.op);
+            else
+                comparison.comparator = &Never;
+            const Column* encoded = lhs != nullptr ? lhs : rhs;
+            if (type == TEXT && (lhs == nullptr) != (rhs == nullptr) && encoded->encoded() &&
+                (comparison.op == EQUAL || comparison.op == NOT_EQUAL)) {
+                Operand& constant = lhs != nullptr ? comparison.rhs : comparison.lhs;
+                constant.code = encoded->Code(constant.text_value);
+                comparison.coded = true;
+                comparison.comparator = comparison.op == EQUAL ? &MatchCode<std::equal_to<>>
+                                                               : &MatchCode<std::not_equal_to<>>;
+            }
+            conjunction.emplace_back(std::move(comparison));
+        }
+        disjuncts_.emplace_back(std::move(conjunction));
+    }
+}
+
+bool Predicate::Evaluate(const size_t* rows) const {
+    for (auto& conjunction : disjuncts_) {
+        bool result = true;
+        for (auto& comparison : conjunction) {
+            if (!comparison.comparator(comparison.lhs, comparison.rhs, rows)) {
+                result = false;
+                break;
+            }
+        }
+        if (result)
+            return true;
+    }
+
+    return false;
+}
+
+static uint64_t CompareWords(Operators op, uint64_t lhs, uint64_t rhs) {
+    switch (op) {
+        case LESS:
+            return ~lhs & rhs;
+        case LESS_EQUAL:
+            return ~lhs | rhs;
+        case GREATER:
+            return lhs & ~rhs;
+        case GREATER_EQUAL:
+            return lhs | ~rhs;
+        case EQUAL:
+            return ~(lhs ^ rhs);
+        case NOT_EQUAL:
+            return lhs ^ rhs;
+    }
+
+    return 0;
+}
+
+void Predicate::Scan(const Comparison& comparison, size_t begin, size_t count, uint64_t* words) {
+    size_t size = (count + 63) / 64;
+    const Operand* lhs = &comparison.lhs;
+    const Operand* rhs = &comparison.rhs;
+    Operators op = comparison.op;
+    if (lhs->column == nullptr) {
+        std::swap(lhs, rhs);
+        op = Flip(op);
+    }
+    const Column* column = lhs->column;
+    const Column* other = rhs->column;
+    bool vectorized = comparison.coded ||
+                      (comparison.comparator != &Never && column != nullptr && column->type() == comparison.type &&
+                       (other == nullptr || other->type() == comparison.type) &&
+                       (comparison.type == INT || comparison.type == DOUBLE || comparison.type == BOOL));
+    if (!vectorized) {
+        std::fill(words, words + size, 0);
+        for (size_t i = 0; i < count; ++i) {
+            size_t row = begin + i;
+            if (comparison.comparator(comparison.lhs, comparison.rhs, &row))
+                words[i / 64] |= uint64_t(1) << (i % 64);
+        }
+        return;
+    }
+    if (comparison.coded) {
+        CompareCodes(op, column->codes() + begin, rhs->code, count, words);
+    } else if (comparison.type == INT) {
+        CompareInts(op, column->ints() + begin, other != nullptr ? other->ints() + begin : nullptr,
+                    rhs->int_value, count, words);
+    } else if (comparison.type == DOUBLE) {
+        CompareDoubles(op, column->doubles() + begin, other != nullptr ? other->doubles() + begin : nullptr,
+                       rhs->double_value, count, words);
+    } else {
+        const uint64_t* bools = column->bools().words() + begin / 64;
+        const uint64_t* others = other != nullptr ? other->bools().words() + begin / 64 : nullptr;
+        uint64_t constant = rhs->bool_value ? ~uint64_t(0) : 0;
+        for (size_t i = 0; i < size; ++i) {
+            words[i] = CompareWords(op, bools[i], others != nullptr ? others[i] : constant);
+        }
+    }
+    for (auto operand : {column, other}) {
+        if (operand == nullptr)
+            continue;
+        const uint64_t* nulls = operand->nulls().words() + begin / 64;
+        for (size_t i = 0; i < size; ++i) {
+            words[i] &= ~nulls[i];
+        }
+    }
+}
+
+size_t Predicate::Filter(size_t begin, size_t end, uint64_t* words) const {
+    size_t count = end - begin;
+    size_t size = (count + 63) / 64;
+    size_t evaluations = 0;
+    std::fill(words, words + size, 0);
+    ArenaScope arena;
+    ArenaVector<uint64_t> conjunction(size);
+    ArenaVector<uint64_t> scratch(size);
+    for (auto& comparisons : disjuncts_) {
+        std::fill(conjunction.begin(), conjunction.end(), ~uint64_t(0));
+        for (auto& comparison : comparisons) {
+            Scan(comparison, begin, count, scratch.data());
+            evaluations += count;
+            uint64_t any = 0;
+            for (size_t i = 0; i < size; ++i) {
+                conjunction[i] &= scratch[i];
+                any |= conjunction[i];
+            }
+            if (any == 0)
+                break;
+        }
+        for (size_t i = 0; i < size; ++i) {
+            words[i] |= conjunction[i];
+        }
+    }
+    if (count % 64 != 0)
+        words[size - 1] &= ~uint64_t(0) >> (64 - count % 64);
+
+    return evaluations;
+}
+
+bool Predicate::EquiJoinKey(const Column*& lhs, const Column*& rhs) const {
+    if (disjuncts_.size() != 1)
+        return false;
+    for (auto& comparison : disjuncts_[0]) {
+        if (comparison.op != EQUAL || comparison.lhs.column == nullptr || comparison.rhs.column == nullptr ||
+            comparison.lhs.slot == comparison.rhs.slot ||
+            comparison.lhs.column->type() != comparison.rhs.column->type())
+            continue;
+        lhs = comparison.lhs.slot == 0 ? comparison.lhs.column : comparison.rhs.column;
+        rhs = comparison.lhs.slot == 0 ? comparison.rhs.column : comparison.lhs.column;
+        return true;
+    }
+
+    return false;
+}
+
+bool Predicate::EqualityKeys(const Column* column, std::vector<std::string>& keys) const {
+    for (auto& conjunction : disjuncts_) {
+        const Operand* constant = nullptr;
+        for (auto& comparison : conjunction) {
+            if (comparison.op != EQUAL)
+                continue;
+            if (comparison.lhs.column == column && comparison.rhs.column == nullptr)
+                constant = &comparison.rhs;
+            else if (comparison.rhs.column == column && comparison.lhs.column == nullptr)
+                constant = &comparison.lhs;
+            if (constant != nullptr)
+                break;
+        }
+        // A constant the key type cannot hold (id = 1.0) may still match after a numeric comparison, so scan.
+        if (constant == nullptr || !Column::IsValid(column->type(), constant->text_value))
+            return false;
+        keys.emplace_back(Column::MakeKey(column->type(), constant->text_value));
+    }
+
+    return true;
+}
+
+bool Predicate::Ranges(const Column* column, std::vector<KeyRange>& ranges) const {
+    for (auto& conjunction : disjuncts_) {
+        KeyRange range;
+        bool bounded = false;
+        for (auto& comparison : conjunction) {
+            Operators op = comparison.op;
+            const Operand* constant = nullptr;
+            if (comparison.lhs.column == column && comparison.rhs.column == nullptr) {
+                constant = &comparison.rhs;
+            } else if (comparison.rhs.column == column && comparison.lhs.column == nullptr) {
+                constant = &comparison.lhs;
+                op = Flip(op);
+            }
+            if (constant == nullptr || op == NOT_EQUAL || !Column::IsValid(column->type(), constant->text_value))
+                continue;
+            std::string key = Column::MakeKey(column->type(), constant->text_value);
+            bounded = true;
+            if (op != LESS && op != LESS_EQUAL) {
+                bool inclusive = op != GREATER;
+                if (!range.has_lower || key > range.lower || (key == range.lower && !inclusive)) {
+                    range.lower = key;
+                    range.lower_inclusive = inclusive;
+                }
+                range.has_lower = true;
+            }
+            if (op != GREATER && op != GREATER_EQUAL) {
+                bool inclusive = op != LESS;
+                if (!range.has_upper || key < range.upper || (key == range.upper && !inclusive)) {
+                    range.upper = key;
+                    range.upper_inclusive = inclusive;
+                }
+                range.has_upper = true;
+            }
+        }
+        if (!bounded)
+            return false;
+        ranges.emplace_back(std::move(range));
+    }
+
+    return true;
+}
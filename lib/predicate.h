@@ -0,0 +1,68 @@
+#pragma once
+
+#include "database.h"
+#include "kernels.h"
+
+namespace DB {
+
+    struct Operand {
+        int slot = -1;
+        const Column* column = nullptr;
+        int64_t int_value = 0;
+        double double_value = 0;
+        bool bool_value = false;
+        std::string text_value;
+        // text_value's code in the dictionary of the column it is compared with.
+        uint32_t code = Column::kNoCode;
+    };
+
+    using Comparator = bool (*)(const Operand& lhs, const Operand& rhs, const size_t* rows);
+
+    class Predicate {
+    private:
+        struct Comparison {
+            Operand lhs;
+            Operand rhs;
+            Operators op;
+            Types type;
+            Comparator comparator;
+            bool coded = false;
+        };
+
+        std::vector<std::vector<Comparison>> disjuncts_;
+
+        static Operators SeeOperator(const std::string& symbol);
+
+        static Operators Flip(Operators op);
+
+        static void Scan(const Comparison& comparison, size_t begin, size_t count, uint64_t* words);
+
+        static Operand Resolve(const std::string& value, const std::vector<std::pair<std::string, Table*>>& tables);
+
+        static bool Bind(Operand& operand, Types type);
+
+        static Comparator Choose(Types type, Operators op);
+
+    public:
+        Predicate() = default;
+
+        Predicate(const std::vector<std::vector<Condition>>& conditions,
+                  const std::vector<std::pair<std::string, Table*>>& tables);
+
+        bool Evaluate(const size_t* rows) const;
+
+        // Single-table predicates only; begin must be a multiple of 64. Returns the number of row comparisons made.
+        size_t Filter(size_t begin, size_t end, uint64_t* words) const;
+
+        bool EquiJoinKey(const Column*& lhs, const Column*& rhs) const;
+
+        bool EqualityKeys(const Column* column, std::vector<std::string>& keys) const;
+
+        bool Ranges(const Column* column, std::vector<KeyRange>& ranges) const;
+
+        bool Evaluate(size_t row) const {
+            return Evaluate(&row);
+        }
+    };
+
+}
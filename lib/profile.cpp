@@ -0,0 +1,112 @@
+#include "profile.h"
+
+#include <cstdlib>
+#include <new>
+
+using namespace DB;
+
+static thread_local Profile* current_profile = nullptr;
+static thread_local size_t allocated_bytes = 0;
+
+#ifdef DB_PROFILE_ALLOCATIONS
+static void* Allocate(size_t size) {
+    allocated_bytes += size;
+    while (true) {
+        if (void* pointer = std::malloc(size == 0 ? 1 : size))
+            return pointer;
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new(size_t size) {
+    return Allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return Allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+#endif
+
+Profile::Profile()
+        : previous_(current_profile)
+{
+    current_profile = this;
+}
+
+Profile::~Profile() {
+    current_profile = previous_;
+}
+
+const std::vector<ProfileStage>& Profile::stages() const {
+    return stages_;
+}
+
+Profile* Profile::current() {
+    return current_profile;
+}
+
+size_t Profile::Allocated() {
+    return allocated_bytes;
+}
+
+void Profile::Charge(size_t bytes) {
+    allocated_bytes += bytes;
+}
+
+ProfileScope::ProfileScope(const char* name)
+        : profile_(current_profile)
+{
+    if (profile_ == nullptr)
+        return;
+    index_ = profile_->stages_.size();
+    ProfileStage& stage = profile_->stages_.emplace_back();
+    stage.name = name;
+    stage.depth = profile_->depth_++;
+    allocated_ = allocated_bytes;
+    start_ = std::chrono::steady_clock::now();
+}
+
+ProfileScope::~ProfileScope() {
+    if (profile_ == nullptr)
+        return;
+    ProfileStage& stage = profile_->stages_[index_];
+    stage.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    stage.bytes = allocated_bytes - allocated_;
+    --profile_->depth_;
+}
+
+void ProfileScope::Detail(const std::string& detail) {
+    if (profile_ != nullptr)
+        profile_->stages_[index_].detail = detail;
+}
+
+void ProfileScope::Rows(size_t in, size_t out) {
+    if (profile_ == nullptr)
+        return;
+    profile_->stages_[index_].rows_in = in;
+    profile_->stages_[index_].rows_out = out;
+}
+
+void ProfileScope::Evaluations(size_t count) {
+    if (profile_ != nullptr)
+        profile_->stages_[index_].evaluations += count;
+}
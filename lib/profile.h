@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace DB {
+
+    // Evaluations count row comparisons for vectorized filters and predicate calls for row-at-a-time paths.
+    // Bytes are everything the stage allocated, including work it handed to the thread pool; they stay zero unless
+    // the library is built with DB_PROFILE_ALLOCATIONS.
+    struct ProfileStage {
+        std::string name;
+        std::string detail;
+        int depth = 0;
+        double seconds = 0;
+        size_t rows_in = 0;
+        size_t rows_out = 0;
+        size_t evaluations = 0;
+        size_t bytes = 0;
+    };
+
+    // Collects the stages of the statements run on this thread while it is alive; profiles nest.
+    class Profile {
+    private:
+        std::vector<ProfileStage> stages_;
+        int depth_ = 0;
+        Profile* previous_;
+
+        friend class ProfileScope;
+
+    public:
+        Profile();
+
+        Profile(const Profile&) = delete;
+
+        Profile& operator=(const Profile&) = delete;
+
+        ~Profile();
+
+        const std::vector<ProfileStage>& stages() const;
+
+        static Profile* current();
+
+        // Bytes allocated by this thread so far; always zero without DB_PROFILE_ALLOCATIONS.
+        static size_t Allocated();
+
+        // Adds bytes another thread allocated on behalf of this one.
+        static void Charge(size_t bytes);
+    };
+
+    // Times one stage of the current profile from construction to destruction; does nothing without one.
+    class ProfileScope {
+    private:
+        Profile* profile_;
+        size_t index_ = 0;
+        std::chrono::steady_clock::time_point start_;
+        size_t allocated_ = 0;
+
+    public:
+        explicit ProfileScope(const char* name);
+
+        ProfileScope(const ProfileScope&) = delete;
+
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+        ~ProfileScope();
+
+        bool active() const {
+            return profile_ != nullptr;
+        }
+
+        void Detail(const std::string& detail);
+
+        void Rows(size_t in, size_t out);
+
+        void Evaluations(size_t count);
+    };
+
+}
+
+// Hooks in the hot paths go through these, so building without DB_PROFILING removes them entirely.
+#ifdef DB_PROFILING
+#define PROFILE_SCOPE(scope, name) DB::ProfileScope scope(name)
+#define PROFILE(...) __VA_ARGS__
+#else
+#define PROFILE_SCOPE(scope, name)
+#define PROFILE(...)
+#endif
@@ -0,0 +1,30 @@
+#include "protocol.h"
+
+#include <cstring>
+
+using namespace DB;
+
+void DB::PutFrame(std::string& out, FrameType type, std::string_view payload) {
+    uint32_t size = static_cast<uint32_t>(payload.size() + 1);
+    char bytes[4];
+    std::memcpy(bytes, &size, 4);
+    out.append(bytes, 4);
+    out += static_cast<char>(type);
+    out += payload;
+}
+
+bool DB::GetFrame(std::string_view& input, FrameType& type, std::string_view& payload, bool& bad) {
+    bad = false;
+    if (input.size() < 4)
+        return false;
+    uint32_t size;
+    std::memcpy(&size, input.data(), 4);
+    bad = size == 0 || size > kMaxFrameSize || (input.size() > 4 && static_cast<uint8_t>(input[4]) > FRAME_END);
+    if (bad || input.size() < 4 + size)
+        return false;
+    type = static_cast<FrameType>(input[4]);
+    payload = input.substr(5, size - 1);
+    input.remove_prefix(4 + size);
+
+    return true;
+}
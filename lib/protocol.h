@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace DB {
+
+    // Every frame is a 4-byte length of the rest, a type byte and the payload. Clients send one statement per
+    // QUERY frame; the server answers each with LINE frames, one per output line, and a closing END frame.
+    enum FrameType : uint8_t {
+        FRAME_QUERY,
+        FRAME_LINE,
+        FRAME_END
+    };
+
+    constexpr uint32_t kMaxFrameSize = 64 << 20;
+
+    void PutFrame(std::string& out, FrameType type, std::string_view payload);
+
+    // Takes one complete frame off the front of input. Returns false when more bytes are needed, or sets bad
+    // when the header cannot be valid.
+    bool GetFrame(std::string_view& input, FrameType& type, std::string_view& payload, bool& bad);
+
+}
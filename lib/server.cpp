@@ -0,0 +1,368 @@
+#include "server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace DB;
+
+Server::~Server() {
+    Stop();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable())
+            worker->thread.join();
+        close(worker->epoll);
+        close(worker->wake);
+    }
+    if (tcp_ >= 0)
+        close(tcp_);
+    if (unix_ >= 0) {
+        close(unix_);
+        unlink(socket_path_.c_str());
+    }
+}
+
+bool Server::Listen(int port, const std::string& socket_path, std::string& message) {
+    std::string places;
+    if (port >= 0) {
+        tcp_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int one = 1;
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (tcp_ < 0 || setsockopt(tcp_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+            bind(tcp_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(tcp_, SOMAXCONN) != 0) {
+            message = "-- CANNOT LISTEN ON PORT " + std::to_string(port) + " --\n";
+            return false;
+        }
+        places = "PORT " + std::to_string(port);
+    }
+    if (!socket_path.empty()) {
+        unix_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (unix_ < 0 || socket_path.size() >= sizeof(address.sun_path)) {
+            message = "-- CANNOT LISTEN ON " + socket_path + " --\n";
+            return false;
+        }
+        std::memcpy(address.sun_path, socket_path.data(), socket_path.size());
+        unlink(socket_path.c_str());
+        if (bind(unix_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(unix_, SOMAXCONN) != 0) {
+            message = "-- CANNOT LISTEN ON " + socket_path + " --\n";
+            return false;
+        }
+        socket_path_ = socket_path;
+        places += (places.empty() ? "" : " AND ") + socket_path;
+    }
+    message = "-- LISTENING ON " + places + " --\n";
+
+    return true;
+}
+
+void Server::Start(size_t workers) {
+    for (size_t i = 0; i < workers; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->epoll = epoll_create1(EPOLL_CLOEXEC);
+        worker->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = worker->wake;
+        epoll_ctl(worker->epoll, EPOLL_CTL_ADD, worker->wake, &event);
+        for (int listener : {tcp_, unix_}) {
+            if (listener < 0)
+                continue;
+            event.events = EPOLLIN | EPOLLEXCLUSIVE;
+            event.data.fd = listener;
+            epoll_ctl(worker->epoll, EPOLL_CTL_ADD, listener, &event);
+        }
+        workers_.emplace_back(std::move(worker));
+    }
+    for (auto& worker : workers_) {
+        worker->thread = std::thread(&Server::Run, this, std::ref(*worker));
+    }
+}
+
+void Server::Stop() {
+    stopping_ = true;
+    uint64_t one = 1;
+    for (auto& worker : workers_) {
+        if (write(worker->wake, &one, sizeof(one)) < 0)
+            continue;
+    }
+}
+
+void Server::Run(Worker& worker) {
+    epoll_event events[kMaxEvents];
+    while (!stopping_) {
+        int count = epoll_wait(worker.epoll, events, kMaxEvents, Expire(worker));
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == tcp_ || fd == unix_) {
+                Accept(worker, fd);
+                continue;
+            }
+            if (fd == worker.wake) {
+                uint64_t value;
+                if (read(worker.wake, &value, sizeof(value)) < 0)
+                    continue;
+                std::vector<Session*> resumed;
+                {
+                    std::lock_guard<std::mutex> lock(worker.mutex);
+                    resumed.swap(worker.resumed);
+                }
+                for (auto session : resumed) {
+                    session->waiting = false;
+                    if (!Process(*session))
+                        Close(*session);
+                }
+                continue;
+            }
+            auto found = worker.sessions.find(fd);
+            if (found == worker.sessions.end())
+                continue;
+            Session& session = *found->second;
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0 && !Receive(session)) {
+                Close(session);
+                continue;
+            }
+            if (!Process(session))
+                Close(session);
+        }
+    }
+    while (!worker.sessions.empty()) {
+        Close(*worker.sessions.begin()->second);
+    }
+}
+
+void Server::Accept(Worker& worker, int listener) {
+    int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+        return;
+    if (listener == tcp_) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    auto session = std::make_unique<Session>(fd, &worker, *database_);
+    session->events = EPOLLIN;
+    epoll_event event{};
+    event.events = session->events;
+    event.data.fd = fd;
+    epoll_ctl(worker.epoll, EPOLL_CTL_ADD, fd, &event);
+    worker.sessions.emplace(fd, std::move(session));
+}
+
+bool Server::Receive(Session& session) {
+    if (session.consumed > 0) {
+        session.input.erase(0, session.consumed);
+        session.consumed = 0;
+    }
+    char buffer[64 << 10];
+    while (session.input.size() < kInputLimit) {
+        ssize_t size = recv(session.fd, buffer, sizeof(buffer), 0);
+        if (size > 0) {
+            session.input.append(buffer, size);
+            continue;
+        }
+        if (size < 0 && errno == EINTR)
+            continue;
+        return size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+
+    return true;
+}
+
+bool Server::Send(Session& session) {
+    while (session.sent < session.output.size()) {
+        ssize_t size = send(session.fd, session.output.data() + session.sent, session.output.size() - session.sent,
+                            MSG_NOSIGNAL);
+        if (size > 0) {
+            session.sent += size;
+            continue;
+        }
+        if (size < 0 && errno == EINTR)
+            continue;
+        return size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+    session.output.clear();
+    session.sent = 0;
+
+    return true;
+}
+
+bool Server::Fill(Session& session) {
+    std::string line;
+    while (session.output.size() - session.sent < kOutputLimit) {
+        if (session.streaming) {
+            if (session.cursor.Next(line)) {
+                PutFrame(session.output, FRAME_LINE, line);
+                continue;
+            }
+            PutFrame(session.output, FRAME_END, {});
+            session.cursor = Cursor();
+            session.streaming = false;
+        }
+        if (session.waiting)
+            return false;
+        std::string_view input(session.input);
+        input.remove_prefix(session.consumed);
+        size_t size = input.size();
+        FrameType type;
+        std::string_view payload;
+        bool complete = GetFrame(input, type, payload, session.broken);
+        if (complete && type != FRAME_QUERY)
+            session.broken = true;
+        if (!complete || session.broken)
+            return false;
+        std::string error;
+        Plan* plan = session.controller.Compile(payload, session.parameters, error);
+        if (plan == nullptr) {
+            session.cursor = Cursor(error);
+        } else {
+            if (session.controller.Writes(*plan) && !Acquire(session)) {
+                if (!session.expired) {
+                    session.waiting = true;
+                    return false;
+                }
+                session.expired = false;
+                session.cursor = Cursor("-- LOCK TIMEOUT: ANOTHER TRANSACTION IS WRITING --\n");
+            } else {
+                session.cursor = session.controller.Run(*plan, session.parameters);
+                if (session.writing && !session.controller.in_transaction())
+                    Release(session);
+            }
+        }
+        session.consumed += size - input.size();
+        session.streaming = true;
+    }
+
+    return true;
+}
+
+bool Server::Process(Session& session) {
+    bool more;
+    do {
+        more = Fill(session);
+        if (session.broken || !Send(session))
+            return false;
+    } while (more && session.output.empty());
+    Watch(session);
+
+    return true;
+}
+
+void Server::Watch(Session& session) {
+    uint32_t events = 0;
+    if (session.input.size() - session.consumed < kInputLimit)
+        events |= EPOLLIN;
+    if (!session.output.empty())
+        events |= EPOLLOUT;
+    if (events == session.events)
+        return;
+    session.events = events;
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = session.fd;
+    epoll_ctl(session.worker->epoll, EPOLL_CTL_MOD, session.fd, &event);
+}
+
+bool Server::Acquire(Session& session) {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    if (writer_ == nullptr)
+        writer_ = &session;
+    if (writer_ != &session) {
+        if (!session.expired) {
+            session.deadline = std::chrono::steady_clock::now() + MyAwesomeDB::kWriterTimeout;
+            waiting_.push_back(&session);
+        }
+        return false;
+    }
+    session.expired = false;
+    session.writing = true;
+
+    return true;
+}
+
+int Server::Expire(Worker& worker) {
+    auto now = std::chrono::steady_clock::now();
+    std::vector<Session*> expired;
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        for (auto session = waiting_.begin(); session != waiting_.end();) {
+            if ((*session)->worker != &worker || (*session)->deadline > now) {
+                ++session;
+                continue;
+            }
+            (*session)->expired = true;
+            expired.push_back(*session);
+            session = waiting_.erase(session);
+        }
+    }
+    for (auto session : expired) {
+        session->waiting = false;
+        if (!Process(*session))
+            Close(*session);
+    }
+    // Processing may have queued sessions again, so look for the next deadline only now.
+    auto next = std::chrono::steady_clock::time_point::max();
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    for (auto session : waiting_) {
+        if (session->worker == &worker)
+            next = std::min(next, session->deadline);
+    }
+    if (next == std::chrono::steady_clock::time_point::max())
+        return -1;
+
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(next - std::chrono::steady_clock::now());
+
+    return static_cast<int>(std::max<int64_t>(wait.count(), 0));
+}
+
+void Server::Release(Session& session) {
+    session.writing = false;
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    auto waiting = std::find(waiting_.begin(), waiting_.end(), &session);
+    if (waiting != waiting_.end())
+        waiting_.erase(waiting);
+    if (writer_ != &session)
+        return;
+    writer_ = nullptr;
+    if (waiting_.empty())
+        return;
+    writer_ = waiting_.front();
+    waiting_.pop_front();
+    Worker& worker = *writer_->worker;
+    std::lock_guard<std::mutex> resume(worker.mutex);
+    worker.resumed.push_back(writer_);
+    uint64_t one = 1;
+    if (write(worker.wake, &one, sizeof(one)) < 0)
+        return;
+}
+
+void Server::Close(Session& session) {
+    Worker& worker = *session.worker;
+    int fd = session.fd;
+    session.cursor = Cursor();
+    Statement rollback;
+    rollback.type = ROLLBACK;
+    session.controller.Run(rollback);
+    Release(session);
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        auto resumed = std::find(worker.resumed.begin(), worker.resumed.end(), &session);
+        if (resumed != worker.resumed.end())
+            worker.resumed.erase(resumed);
+    }
+    epoll_ctl(worker.epoll, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    worker.sessions.erase(fd);
+}
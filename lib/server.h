@@ -0,0 +1,112 @@
+#pragma once
+
+#include "DB_controller.h"
+#include "protocol.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace DB {
+
+    class Server {
+    private:
+        struct Worker;
+
+        struct Session {
+            int fd;
+            Worker* worker;
+            Controller controller;
+            std::string input;
+            size_t consumed = 0;
+            std::string output;
+            size_t sent = 0;
+            Cursor cursor;
+            std::vector<std::string> parameters;
+            uint32_t events = 0;
+            bool streaming = false;
+            bool waiting = false;
+            // Set once the session waited kWriterTimeout for another session's transaction to give up the writer.
+            bool expired = false;
+            std::chrono::steady_clock::time_point deadline;
+            bool writing = false;
+            bool broken = false;
+
+            Session(int fd, Worker* worker, MyAwesomeDB& database)
+                    : fd(fd)
+                    , worker(worker)
+                    , controller(database)
+            {}
+        };
+
+        struct Worker {
+            int epoll = -1;
+            int wake = -1;
+            std::thread thread;
+            std::mutex mutex;
+            std::vector<Session*> resumed;
+            std::unordered_map<int, std::unique_ptr<Session>> sessions;
+        };
+
+        static constexpr size_t kOutputLimit = 256 << 10;
+        static constexpr size_t kInputLimit = 16 << 20;
+        static constexpr int kMaxEvents = 256;
+
+        MyAwesomeDB* database_;
+        int tcp_ = -1;
+        int unix_ = -1;
+        std::string socket_path_;
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::atomic<bool> stopping_{false};
+        std::mutex writer_mutex_;
+        Session* writer_ = nullptr;
+        std::deque<Session*> waiting_;
+
+        void Run(Worker& worker);
+
+        void Accept(Worker& worker, int listener);
+
+        bool Receive(Session& session);
+
+        bool Send(Session& session);
+
+        bool Fill(Session& session);
+
+        bool Process(Session& session);
+
+        void Watch(Session& session);
+
+        bool Acquire(Session& session);
+
+        // Fails the statements of worker's sessions that waited too long for the writer, and returns how many
+        // milliseconds the next one may still wait (-1 for none).
+        int Expire(Worker& worker);
+
+        void Release(Session& session);
+
+        void Close(Session& session);
+
+    public:
+        explicit Server(MyAwesomeDB& database)
+                : database_(&database)
+        {}
+
+        Server(const Server&) = delete;
+
+        Server& operator=(const Server&) = delete;
+
+        ~Server();
+
+        bool Listen(int port, const std::string& socket_path, std::string& message);
+
+        void Start(size_t workers);
+
+        void Stop();
+    };
+
+}
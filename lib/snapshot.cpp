@@ -0,0 +1,117 @@
+#include "snapshot.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace DB;
+
+static const char kMagic[8] = {'M', 'A', 'D', 'B', 'S', 'N', 'A', 'P'};
+
+Snapshot::~Snapshot() {
+    if (fd_ >= 0)
+        close(fd_);
+}
+
+LogRecord& Snapshot::catalog() {
+    return catalog_;
+}
+
+void Snapshot::Write(const char* data, size_t size) {
+    size_t written = 0;
+    while (!failed_ && written < size) {
+        ssize_t count = pwrite(fd_, data + written, size - written, static_cast<off_t>(offset_ + written));
+        if (count < 0)
+            failed_ = true;
+        else
+            written += count;
+    }
+    offset_ = (offset_ + size + kPageSize - 1) / kPageSize * kPageSize;
+}
+
+bool Snapshot::Create(const std::string& path) {
+    path_ = path;
+    fd_ = open((path_ + ".tmp").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    return fd_ >= 0;
+}
+
+bool Snapshot::Commit(uint64_t generation) {
+    const std::string& catalog = catalog_.payload();
+    uint64_t catalog_offset = offset_;
+    Write(catalog.data(), catalog.size());
+
+    char header[kHeaderSize];
+    uint32_t version = kVersion;
+    uint32_t page_size = kPageSize;
+    uint64_t catalog_size = catalog.size();
+    uint32_t crc = Crc32(catalog.data(), catalog.size());
+    std::memcpy(header, kMagic, 8);
+    std::memcpy(header + 8, &version, 4);
+    std::memcpy(header + 12, &page_size, 4);
+    std::memcpy(header + 16, &generation, 8);
+    std::memcpy(header + 24, &catalog_offset, 8);
+    std::memcpy(header + 32, &catalog_size, 8);
+    std::memcpy(header + 40, &crc, 4);
+    uint64_t end = offset_;
+    offset_ = 0;
+    Write(header, kHeaderSize);
+    if (failed_ || ftruncate(fd_, static_cast<off_t>(end)) != 0 || fdatasync(fd_) != 0)
+        return false;
+    close(fd_);
+    fd_ = -1;
+    if (rename((path_ + ".tmp").c_str(), path_.c_str()) != 0)
+        return false;
+    size_t slash = path_.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path_.substr(0, slash);
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
+        return false;
+    bool synced = fsync(fd) == 0;
+    close(fd);
+
+    return synced;
+}
+
+bool Snapshot::Open(const std::string& path, uint64_t& generation) {
+    fd_ = open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd_ < 0 || fstat(fd_, &status) != 0 || static_cast<size_t>(status.st_size) < kPageSize)
+        return false;
+    size_ = status.st_size;
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (data == MAP_FAILED)
+        return false;
+    size_t size = size_;
+    mapping_ = std::shared_ptr<const char>(static_cast<const char*>(data),
+                                           [size](const char* pointer) {
+                                               munmap(const_cast<char*>(pointer), size);
+                                           });
+
+    const char* header = mapping_.get();
+    uint32_t version;
+    uint32_t page_size;
+    uint64_t catalog_offset;
+    uint64_t catalog_size;
+    uint32_t crc;
+    std::memcpy(&version, header + 8, 4);
+    std::memcpy(&page_size, header + 12, 4);
+    std::memcpy(&generation, header + 16, 8);
+    std::memcpy(&catalog_offset, header + 24, 8);
+    std::memcpy(&catalog_size, header + 32, 8);
+    std::memcpy(&crc, header + 40, 4);
+    if (std::memcmp(header, kMagic, 8) != 0 || version == 0 || version > kVersion || page_size != kPageSize ||
+        catalog_offset > size_ || catalog_size > size_ - catalog_offset ||
+        Crc32(header + catalog_offset, catalog_size) != crc)
+        return false;
+    catalog_ = LogRecord(LOG_CHECKPOINT, std::string(header + catalog_offset, catalog_size));
+    version_ = version;
+
+    return true;
+}
+
+uint32_t Snapshot::version() const {
+    return version_;
+}
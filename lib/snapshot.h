@@ -0,0 +1,66 @@
+#pragma once
+
+#include "database.h"
+#include "wal.h"
+
+namespace DB {
+
+    class Snapshot {
+    private:
+        static constexpr uint32_t kVersion = 4;
+        static constexpr size_t kPageSize = 4096;
+        static constexpr size_t kHeaderSize = 44;
+
+        int fd_ = -1;
+        std::string path_;
+        uint64_t offset_ = kPageSize;
+        bool failed_ = false;
+        std::shared_ptr<const char> mapping_;
+        size_t size_ = 0;
+        uint32_t version_ = kVersion;
+        LogRecord catalog_;
+
+        void Write(const char* data, size_t size);
+
+    public:
+        Snapshot()
+                : catalog_(LOG_CHECKPOINT)
+        {}
+
+        Snapshot(const Snapshot&) = delete;
+
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        ~Snapshot();
+
+        LogRecord& catalog();
+
+        bool Create(const std::string& path);
+
+        bool Commit(uint64_t generation);
+
+        bool Open(const std::string& path, uint64_t& generation);
+
+        // The format version of an opened snapshot; older versions are still read.
+        uint32_t version() const;
+
+        template <typename T>
+        void PutArray(const Buffer<T>& buffer) {
+            catalog_.PutNumber(offset_);
+            catalog_.PutNumber(buffer.size());
+            Write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(T));
+        }
+
+        template <typename T>
+        bool GetArray(Buffer<T>& buffer) {
+            uint64_t offset;
+            uint64_t count;
+            if (!catalog_.GetNumber(offset) || !catalog_.GetNumber(count) || offset % kPageSize != 0 ||
+                offset > size_ || count > (size_ - offset) / sizeof(T))
+                return false;
+            buffer.View(mapping_, reinterpret_cast<const T*>(mapping_.get() + offset), count);
+            return true;
+        }
+    };
+
+}
@@ -0,0 +1,149 @@
+#include "sort.h"
+#include "arena.h"
+#include "profile.h"
+#include "thread_pool.h"
+
+#include <cstring>
+
+using namespace DB;
+
+bool Sorter::Resolve(Table* table, std::string& message) {
+    for (auto& order : order_by_) {
+        size_t dot = order.column.find('.');
+        std::string name = dot == std::string::npos ? order.column : order.column.substr(dot + 1);
+        if (!table->IsColumnName(name)) {
+            message = "-- NO COLUMN " + order.column + " FOUND --\n";
+            return false;
+        }
+        const Column& column = table->GetColumn(name);
+        Key& key = keys_.emplace_back();
+        key.column = &column;
+        key.type = column.type();
+        key.nulls = column.nulls().words();
+        key.ints = column.ints();
+        key.doubles = column.doubles();
+        key.descending = order.descending;
+    }
+    exact_ = keys_.size() == 1 && keys_[0].type != TEXT;
+
+    return true;
+}
+
+bool Sorter::Less(size_t lhs, size_t rhs) const {
+    for (auto& key : keys_) {
+        bool lhs_null = (key.nulls[lhs / 64] >> (lhs % 64) & 1) != 0;
+        bool rhs_null = (key.nulls[rhs / 64] >> (rhs % 64) & 1) != 0;
+        int order;
+        if (lhs_null || rhs_null)
+            order = int(lhs_null) - int(rhs_null);
+        else if (key.type == INT)
+            order = (key.ints[lhs] > key.ints[rhs]) - (key.ints[lhs] < key.ints[rhs]);
+        else if (key.type == DOUBLE)
+            order = (key.doubles[lhs] > key.doubles[rhs]) - (key.doubles[lhs] < key.doubles[rhs]);
+        else if (key.type == BOOL)
+            order = int(key.column->GetBool(lhs)) - int(key.column->GetBool(rhs));
+        else
+            order = key.column->GetText(lhs).compare(key.column->GetText(rhs));
+        if (order != 0)
+            return key.descending ? order > 0 : order < 0;
+    }
+
+    return lhs < rhs;
+}
+
+uint64_t Sorter::Prefix(size_t row) const {
+    const Key& key = keys_[0];
+    uint64_t prefix = UINT64_MAX;
+    if ((key.nulls[row / 64] >> (row % 64) & 1) != 0) {
+    } else if (key.type == INT) {
+        prefix = static_cast<uint64_t>(key.ints[row]) ^ (uint64_t(1) << 63);
+    } else if (key.type == DOUBLE) {
+        double value = key.doubles[row] == 0 ? 0.0 : key.doubles[row];
+        std::memcpy(&prefix, &value, sizeof(prefix));
+        prefix = (prefix >> 63) != 0 ? ~prefix : prefix | (uint64_t(1) << 63);
+    } else if (key.type == BOOL) {
+        prefix = key.column->GetBool(row);
+    } else {
+        std::string_view text = key.column->GetText(row);
+        prefix = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            prefix = prefix << 8 | (i < text.size() ? static_cast<unsigned char>(text[i]) : 0);
+        }
+    }
+
+    return key.descending ? ~prefix : prefix;
+}
+
+std::vector<size_t> Sorter::Run(const Bitmap& selected, size_t limit, ThreadPool& pool) const {
+    if (limit == 0)
+        return {};
+    PROFILE_SCOPE(stage, "sort");
+    // Only the per-morsel heaps are grown by the workers, so they stay off the arena.
+    ArenaScope arena;
+    ArenaVector<Entry> entries;
+    entries.reserve(selected.Count());
+    for (size_t row = selected.Next(0); row < selected.Size(); row = selected.Next(row + 1)) {
+        entries.push_back({0, row});
+    }
+    pool.ParallelFor(entries.size(), kMorselRows, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            entries[i].prefix = Prefix(entries[i].row);
+        }
+    });
+    auto less = [this](const Entry& lhs, const Entry& rhs) {
+        if (lhs.prefix != rhs.prefix)
+            return lhs.prefix < rhs.prefix;
+        if (exact_ && lhs.prefix != 0 && lhs.prefix != UINT64_MAX)
+            return lhs.row < rhs.row;
+        return Less(lhs.row, rhs.row);
+    };
+    if (limit < entries.size() && limit < kMorselRows) {
+        PROFILE(stage.Detail("top-" + std::to_string(limit) + " heaps"));
+        auto push = [&](auto& heap, const Entry& entry) {
+            if (heap.size() < limit) {
+                heap.emplace_back(entry);
+                std::push_heap(heap.begin(), heap.end(), less);
+            } else if (less(entry, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), less);
+                heap.back() = entry;
+                std::push_heap(heap.begin(), heap.end(), less);
+            }
+        };
+        std::vector<std::vector<Entry>> heaps((entries.size() + kMorselRows - 1) / kMorselRows);
+        pool.ParallelFor(entries.size(), kMorselRows, [&](size_t begin, size_t end) {
+            auto& heap = heaps[begin / kMorselRows];
+            for (size_t i = begin; i < end; ++i) {
+                push(heap, entries[i]);
+            }
+        });
+        entries.clear();
+        for (auto& heap : heaps) {
+            for (auto& entry : heap) {
+                push(entries, entry);
+            }
+        }
+        std::sort_heap(entries.begin(), entries.end(), less);
+    } else {
+        PROFILE(stage.Detail("parallel merge sort"));
+        size_t run = std::max(kMorselRows, (entries.size() + pool.size() - 1) / pool.size());
+        pool.ParallelFor(entries.size(), run, [&](size_t begin, size_t end) {
+            std::sort(entries.begin() + begin, entries.begin() + end, less);
+        });
+        ArenaVector<Entry> merged(entries.size());
+        for (; run < entries.size(); run *= 2) {
+            pool.ParallelFor(entries.size(), run * 2, [&](size_t begin, size_t end) {
+                size_t middle = std::min(begin + run, end);
+                std::merge(entries.begin() + begin, entries.begin() + middle, entries.begin() + middle,
+                           entries.begin() + end, merged.begin() + begin, less);
+            });
+            entries.swap(merged);
+        }
+    }
+    std::vector<size_t> rows(std::min(entries.size(), limit));
+    for (size_t i = 0; i < rows.size(); ++i) {
+        rows[i] = entries[i].row;
+    }
+    PROFILE(stage.Rows(selected.Count(), rows.size()));
+
+    return rows;
+}
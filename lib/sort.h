@@ -0,0 +1,47 @@
+#pragma once
+
+#include "database.h"
+
+namespace DB {
+
+    // Orders row ids of one table by its ORDER BY keys; rows themselves are never copied. NULLs sort after every
+    // value in ascending order, and equal keys keep row order.
+    class Sorter {
+    private:
+        struct Key {
+            const Column* column = nullptr;
+            Types type = UNKNOWN;
+            const uint64_t* nulls = nullptr;
+            const int64_t* ints = nullptr;
+            const double* doubles = nullptr;
+            bool descending = false;
+        };
+
+        // The first key of a row as an unsigned integer in sort order. Rows whose prefixes tie go to Less, unless
+        // the prefix is the whole key (exact_) and cannot also be the NULL marker.
+        struct Entry {
+            uint64_t prefix;
+            size_t row;
+        };
+
+        std::vector<OrderBy> order_by_;
+        std::vector<Key> keys_;
+        bool exact_ = false;
+
+        bool Less(size_t lhs, size_t rhs) const;
+
+        uint64_t Prefix(size_t row) const;
+
+    public:
+        explicit Sorter(const std::vector<OrderBy>& order_by)
+                : order_by_(order_by)
+        {}
+
+        bool Resolve(Table* table, std::string& message);
+
+        // Returns at most limit rows. A limit smaller than a morsel keeps a bounded heap per morsel instead of
+        // sorting; otherwise runs are sorted in parallel and merged pairwise.
+        std::vector<size_t> Run(const Bitmap& selected, size_t limit, ThreadPool& pool) const;
+    };
+
+}
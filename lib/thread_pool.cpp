@@ -0,0 +1,111 @@
+#include "thread_pool.h"
+#include "arena.h"
+#include "profile.h"
+
+#include <algorithm>
+
+using namespace DB;
+
+ThreadPool::ThreadPool(size_t threads) {
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; ++i) {
+        queues_.emplace_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 1; i < threads; ++i) {
+        workers_.emplace_back(&ThreadPool::Run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::size() const {
+    return queues_.size();
+}
+
+bool ThreadPool::Pop(size_t index, std::function<void()>& task) {
+    for (size_t i = 0; i < queues_.size(); ++i) {
+        auto& queue = *queues_[(index + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        --queued_;
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::Run(size_t index) {
+    std::function<void()> task;
+    while (true) {
+        if (Pop(index, task)) {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+        if (stopping_)
+            return;
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t morsel, const std::function<void(size_t, size_t)>& body) {
+    size_t morsels = (count + morsel - 1) / morsel;
+    if (workers_.empty() || morsels <= 1) {
+        if (count > 0) {
+            ArenaScope arena;
+            body(0, count);
+        }
+        return;
+    }
+    std::atomic<size_t> remaining(morsels);
+    std::mutex done_mutex;
+    std::condition_variable done;
+    PROFILE(Profile* profile = Profile::current());
+    PROFILE(std::atomic<size_t> charged(0));
+    for (size_t i = 0; i < morsels; ++i) {
+        auto& queue = *queues_[i % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.emplace_back([&, i] {
+            PROFILE(size_t allocated = Profile::Allocated());
+            {
+                ArenaScope arena;
+                body(i * morsel, std::min(count, (i + 1) * morsel));
+            }
+            PROFILE(if (profile != nullptr && Profile::current() != profile)
+                        charged += Profile::Allocated() - allocated);
+            std::lock_guard<std::mutex> lock(done_mutex);
+            if (--remaining == 0)
+                done.notify_one();
+        });
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_ += morsels;
+    }
+    wake_.notify_all();
+
+    std::function<void()> task;
+    while (remaining > 0 && Pop(0, task)) {
+        task();
+    }
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done.wait(lock, [&] { return remaining == 0; });
+    PROFILE(Profile::Charge(charged));
+}
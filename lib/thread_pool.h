@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DB {
+
+    // Rows per morsel for every parallel scan. Predicate::Filter and the Bitmap writers need morsels to start on a
+    // 64-row word boundary, so parallel morsels never share a word of a selection Bitmap.
+    constexpr size_t kMorselRows = 16384;
+
+    static_assert(kMorselRows % 64 == 0, "morsels must not share a Bitmap word");
+
+    class ThreadPool {
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues_;
+        std::vector<std::thread> workers_;
+        std::atomic<size_t> queued_{0};
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        bool stopping_ = false;
+
+        bool Pop(size_t index, std::function<void()>& task);
+
+        void Run(size_t index);
+
+    public:
+        explicit ThreadPool(size_t threads);
+
+        ThreadPool(const ThreadPool&) = delete;
+
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool();
+
+        size_t size() const;
+
+        // Each morsel runs in its own ArenaScope, so body may use the arena for scratch but must not grow arena memory
+        // it did not allocate.
+        void ParallelFor(size_t count, size_t morsel, const std::function<void(size_t, size_t)>& body);
+    };
+
+}
@@ -0,0 +1,306 @@
+#include "wal.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace DB;
+
+static const std::array<uint32_t, 256> kCrcTable = [] {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit)
+            crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320u : 0);
+        table[i] = crc;
+    }
+    return table;
+}();
+
+uint32_t DB::Crc32(const char* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i)
+        crc = kCrcTable[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+
+    return crc ^ 0xFFFFFFFFu;
+}
+
+static void PutUint32(std::string& out, uint32_t value) {
+    char bytes[4];
+    std::memcpy(bytes, &value, 4);
+    out.append(bytes, 4);
+}
+
+static uint32_t GetUint32(const char* data) {
+    uint32_t value;
+    std::memcpy(&value, data, 4);
+
+    return value;
+}
+
+RecordType LogRecord::type() const {
+    return type_;
+}
+
+const std::string& LogRecord::payload() const {
+    return payload_;
+}
+
+void LogRecord::PutNumber(uint64_t value) {
+    char bytes[8];
+    std::memcpy(bytes, &value, 8);
+    payload_.append(bytes, 8);
+}
+
+void LogRecord::PutString(const std::string& value) {
+    PutUint32(payload_, static_cast<uint32_t>(value.size()));
+    payload_ += value;
+}
+
+void LogRecord::PutStrings(const std::vector<std::string>& values) {
+    PutUint32(payload_, static_cast<uint32_t>(values.size()));
+    for (auto& value : values)
+        PutString(value);
+}
+
+void LogRecord::PutPairs(const std::vector<std::pair<std::string, std::string>>& values) {
+    PutUint32(payload_, static_cast<uint32_t>(values.size()));
+    for (auto& pair : values) {
+        PutString(pair.first);
+        PutString(pair.second);
+    }
+}
+
+void LogRecord::PutConditions(const std::vector<std::vector<Condition>>& conditions) {
+    PutUint32(payload_, static_cast<uint32_t>(conditions.size()));
+    for (auto& conjunction : conditions) {
+        PutUint32(payload_, static_cast<uint32_t>(conjunction.size()));
+        for (auto& condition : conjunction) {
+            PutString(condition.symbol());
+            PutString(condition.lhs());
+            PutString(condition.rhs());
+        }
+    }
+}
+
+bool LogRecord::GetNumber(uint64_t& value) {
+    if (payload_.size() - position_ < 8)
+        return false;
+    std::memcpy(&value, payload_.data() + position_, 8);
+    position_ += 8;
+
+    return true;
+}
+
+bool LogRecord::GetString(std::string& value) {
+    if (payload_.size() - position_ < 4)
+        return false;
+    uint32_t size = GetUint32(payload_.data() + position_);
+    position_ += 4;
+    if (payload_.size() - position_ < size)
+        return false;
+    value.assign(payload_, position_, size);
+    position_ += size;
+
+    return true;
+}
+
+bool LogRecord::GetStrings(std::vector<std::string>& values) {
+    if (payload_.size() - position_ < 4)
+        return false;
+    uint32_t count = GetUint32(payload_.data() + position_);
+    position_ += 4;
+    values.resize(count);
+    for (auto& value : values) {
+        if (!GetString(value))
+            return false;
+    }
+
+    return true;
+}
+
+bool LogRecord::GetPairs(std::vector<std::pair<std::string, std::string>>& values) {
+    if (payload_.size() - position_ < 4)
+        return false;
+    uint32_t count = GetUint32(payload_.data() + position_);
+    position_ += 4;
+    values.resize(count);
+    for (auto& pair : values) {
+        if (!GetString(pair.first) || !GetString(pair.second))
+            return false;
+    }
+
+    return true;
+}
+
+bool LogRecord::GetConditions(std::vector<std::vector<Condition>>& conditions) {
+    if (payload_.size() - position_ < 4)
+        return false;
+    uint32_t count = GetUint32(payload_.data() + position_);
+    position_ += 4;
+    conditions.resize(count);
+    for (auto& conjunction : conditions) {
+        if (payload_.size() - position_ < 4)
+            return false;
+        uint32_t size = GetUint32(payload_.data() + position_);
+        position_ += 4;
+        for (uint32_t i = 0; i < size; ++i) {
+            std::string symbol;
+            std::string lhs;
+            std::string rhs;
+            if (!GetString(symbol) || !GetString(lhs) || !GetString(rhs))
+                return false;
+            conjunction.emplace_back(symbol, lhs, rhs);
+        }
+    }
+
+    return true;
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    if (flusher_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        pending_.notify_one();
+        flusher_.join();
+    }
+    if (fd_ >= 0) {
+        if (!buffer_.empty())
+            Write(buffer_);
+        close(fd_);
+    }
+}
+
+bool WriteAheadLog::Open(const std::string& path, Durability durability, std::vector<LogRecord>& records) {
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0)
+        return false;
+    durability_ = durability;
+    std::string data;
+    char chunk[1 << 16];
+    ssize_t count;
+    while ((count = read(fd_, chunk, sizeof(chunk))) > 0)
+        data.append(chunk, count);
+    if (count < 0)
+        return false;
+
+    size_t position = 0;
+    while (data.size() - position >= 9) {
+        uint32_t size = GetUint32(data.data() + position);
+        uint32_t crc = GetUint32(data.data() + position + 4);
+        if (size == 0 || data.size() - position - 8 < size || Crc32(data.data() + position + 8, size) != crc)
+            break;
+        records.emplace_back(static_cast<RecordType>(data[position + 8]), data.substr(position + 9, size - 1));
+        position += 8 + size;
+    }
+    if (position != data.size() && ftruncate(fd_, static_cast<off_t>(position)) != 0)
+        return false;
+    if (lseek(fd_, static_cast<off_t>(position), SEEK_SET) < 0)
+        return false;
+    if (durability_ == GROUP_COMMIT)
+        flusher_ = std::thread(&WriteAheadLog::Flush, this);
+
+    return true;
+}
+
+bool WriteAheadLog::Write(const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t count = write(fd_, data.data() + written, data.size() - written);
+        if (count < 0)
+            return false;
+        written += count;
+    }
+
+    return true;
+}
+
+void WriteAheadLog::Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        pending_.wait(lock, [this] { return stopping_ || !buffer_.empty(); });
+        if (buffer_.empty())
+            break;
+        std::string batch;
+        batch.swap(buffer_);
+        uint64_t lsn = appended_;
+        lock.unlock();
+        bool ok = Write(batch) && fdatasync(fd_) == 0;
+        lock.lock();
+        if (!ok)
+            lost_ = std::min(lost_, durable_ + 1);
+        durable_ = lsn;
+        flushed_.notify_all();
+    }
+}
+
+void WriteAheadLog::Frame(const LogRecord& record, std::string& out) {
+    std::string body;
+    body.reserve(record.payload().size() + 1);
+    body += static_cast<char>(record.type());
+    body += record.payload();
+    PutUint32(out, static_cast<uint32_t>(body.size()));
+    PutUint32(out, Crc32(body.data(), body.size()));
+    out += body;
+}
+
+uint64_t WriteAheadLog::Append(const LogRecord& record) {
+    std::string frame;
+    Frame(record, frame);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer_ += frame;
+
+    return ++appended_;
+}
+
+bool WriteAheadLog::Commit(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (durability_ == GROUP_COMMIT) {
+        pending_.notify_one();
+        flushed_.wait(lock, [this, lsn] { return durable_ >= lsn; });
+        return lsn < lost_;
+    }
+    if (durable_ >= lsn)
+        return lsn < lost_;
+    bool ok = Write(buffer_);
+    if (ok && durability_ == FSYNC_EACH)
+        ok = fdatasync(fd_) == 0;
+    buffer_.clear();
+    if (!ok)
+        lost_ = std::min(lost_, durable_ + 1);
+    durable_ = appended_;
+
+    return lsn < lost_;
+}
+
+bool WriteAheadLog::Reset(const LogRecord& record) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (durability_ == GROUP_COMMIT) {
+        pending_.notify_one();
+        flushed_.wait(lock, [this] { return durable_ >= appended_; });
+    }
+    buffer_.clear();
+    durable_ = appended_;
+    std::string frame;
+    Frame(record, frame);
+
+    return ftruncate(fd_, 0) == 0 && lseek(fd_, 0, SEEK_SET) == 0 && Write(frame) && fdatasync(fd_) == 0;
+}
+
+bool WriteAheadLog::SeeDurability(const std::string& name, Durability& durability) {
+    if (name == "fsync")
+        durability = FSYNC_EACH;
+    else if (name == "group")
+        durability = GROUP_COMMIT;
+    else if (name == "buffered")
+        durability = OS_BUFFERED;
+    else
+        return false;
+
+    return true;
+}
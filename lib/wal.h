@@ -0,0 +1,108 @@
+#pragma once
+
+#include "database.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace DB {
+
+    enum RecordType : uint8_t {
+        LOG_CREATE_TABLE,
+        LOG_DROP_TABLE,
+        LOG_CREATE_INDEX,
+        LOG_DROP_INDEX,
+        LOG_INSERT,
+        LOG_DELETE,
+        LOG_UPDATE,
+        LOG_CHECKPOINT,
+        LOG_COPY,
+        LOG_TRANSACTION
+    };
+
+    uint32_t Crc32(const char* data, size_t size);
+
+    class LogRecord {
+    private:
+        RecordType type_;
+        std::string payload_;
+        size_t position_ = 0;
+
+    public:
+        explicit LogRecord(RecordType type)
+                : type_(type)
+        {}
+
+        LogRecord(RecordType type, std::string payload)
+                : type_(type)
+                , payload_(std::move(payload))
+        {}
+
+        RecordType type() const;
+
+        const std::string& payload() const;
+
+        void PutNumber(uint64_t value);
+
+        void PutString(const std::string& value);
+
+        void PutStrings(const std::vector<std::string>& values);
+
+        void PutPairs(const std::vector<std::pair<std::string, std::string>>& values);
+
+        void PutConditions(const std::vector<std::vector<Condition>>& conditions);
+
+        bool GetNumber(uint64_t& value);
+
+        bool GetString(std::string& value);
+
+        bool GetStrings(std::vector<std::string>& values);
+
+        bool GetPairs(std::vector<std::pair<std::string, std::string>>& values);
+
+        bool GetConditions(std::vector<std::vector<Condition>>& conditions);
+    };
+
+    class WriteAheadLog {
+    private:
+        int fd_ = -1;
+        Durability durability_ = GROUP_COMMIT;
+        std::string buffer_;
+        uint64_t appended_ = 0;
+        uint64_t durable_ = 0;
+        // First LSN a failed write may have lost; it and every later record are reported as not durable.
+        uint64_t lost_ = UINT64_MAX;
+        bool stopping_ = false;
+        std::mutex mutex_;
+        std::condition_variable pending_;
+        std::condition_variable flushed_;
+        std::thread flusher_;
+
+        bool Write(const std::string& data);
+
+        static void Frame(const LogRecord& record, std::string& out);
+
+        void Flush();
+
+    public:
+        WriteAheadLog() = default;
+
+        WriteAheadLog(const WriteAheadLog&) = delete;
+
+        WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+        ~WriteAheadLog();
+
+        bool Open(const std::string& path, Durability durability, std::vector<LogRecord>& records);
+
+        uint64_t Append(const LogRecord& record);
+
+        bool Commit(uint64_t lsn);
+
+        bool Reset(const LogRecord& record);
+
+        static bool SeeDurability(const std::string& name, Durability& durability);
+    };
+
+}
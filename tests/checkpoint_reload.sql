@@ -0,0 +1,20 @@
+CREATE TABLE items (id INT, name TEXT, price DOUBLE, sold BOOL, PRIMARY KEY(id));
+INSERT INTO items (id, name, price, sold) VALUES (1, 'pen', 1.5, TRUE), (2, 'ink', 7.25, FALSE), (3, 'pad', 3, TRUE);
+INSERT INTO items (id, name) VALUES (4, 'pen');
+DELETE FROM items WHERE id = 3;
+CREATE INDEX by_name ON items (name);
+CREATE TABLE empty (x INT);
+CHECKPOINT;
+INSERT INTO items (id, name, price, sold) VALUES (5, 'cap', 2, FALSE);
+UPDATE items SET price = 8 WHERE id = 2;
+STOP
+SELECT * FROM items ORDER BY id;
+SELECT * FROM items WHERE name = 'pen' ORDER BY id;
+SELECT COUNT(*) FROM empty;
+CREATE INDEX by_name ON items (name);
+CHECKPOINT;
+DELETE FROM items WHERE name = 'pen';
+STOP
+SELECT * FROM items ORDER BY id;
+SELECT * FROM items WHERE name = 'cap';
+STOP
@@ -0,0 +1,15 @@
+CREATE TABLE people (id INT, name TEXT, score DOUBLE, ok BOOL, PRIMARY KEY(id));
+COPY people (id, name, score, ok) FROM '@DATA@/copy_people.csv' WITH (HEADER);
+COPY people (id, name, score, ok) FROM '@DATA@/copy_semicolon.csv' WITH (DELIMITER ';');
+COPY people (id, name, score, ok) FROM '@DATA@/copy_bad_value.csv' WITH (HEADER);
+COPY people (id, name, score, ok) FROM '@DATA@/copy_unterminated.csv';
+COPY people (id, name, score, ok) FROM '@DATA@/copy_short_row.csv';
+COPY people (id, name, score, ok) FROM '@DATA@/copy_duplicate.csv';
+COPY people (id, name, score, ok) FROM '@DATA@/missing.csv';
+COPY people (id, nope) FROM '@DATA@/copy_people.csv';
+COPY nope FROM '@DATA@/copy_people.csv';
+SELECT * FROM people ORDER BY id;
+STOP
+SELECT * FROM people ORDER BY id;
+SELECT COUNT(*), COUNT(score), COUNT(name) FROM people;
+STOP
@@ -0,0 +1,6 @@
+CREATE TABLE z (a INT, b TEXT);
+INSERT INTO z (a, b) VALUES (2, 'x'), (1, 'y'), (2, 'z'), (3, 'x'), (1, 'x');
+SELECT a FROM z GROUP BY a;
+SELECT a, b FROM z GROUP BY a, b;
+SELECT b FROM z WHERE a > 1 GROUP BY b;
+STOP
@@ -0,0 +1,10 @@
+CREATE TABLE o (a INT, g TEXT);
+INSERT INTO o (a, g) VALUES (9223372036854775807, 'x'), (1, 'x'), (5, 'y'), (-9223372036854775808, 'z'), (-1, 'z');
+SELECT SUM(a) FROM o WHERE g = 'x';
+SELECT AVG(a) FROM o WHERE g = 'x';
+SELECT g, SUM(a) FROM o GROUP BY g;
+SELECT g, AVG(a) FROM o GROUP BY g;
+SELECT SUM(a) FROM o WHERE g = 'z';
+SELECT SUM(a), COUNT(*) FROM o WHERE g = 'x' OR g = 'z';
+SELECT g, SUM(a) FROM o WHERE g = 'y' GROUP BY g;
+STOP
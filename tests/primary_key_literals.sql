@@ -0,0 +1,9 @@
+CREATE TABLE t (id INT, v TEXT, PRIMARY KEY(id));
+INSERT INTO t (id, v) VALUES (1, 'a'), (2, 'b'), (3, 'c');
+SELECT * FROM t WHERE id = 1.0;
+SELECT * FROM t WHERE id = 2.5;
+SELECT * FROM t WHERE id = 1.0 OR id = 3;
+UPDATE t SET v = 'z' WHERE id = 2.0;
+DELETE FROM t WHERE id = 3.0;
+SELECT * FROM t;
+STOP
@@ -0,0 +1,52 @@
+# Feeds INPUT to the shell binary MAIN and compares what it prints with EXPECTED.
+#
+# Every STOP line ends a session, and each session runs in a new process. With WAL set, the sessions share the log
+# WORK/db.wal, which starts empty, and a session whose first line is TEAR first gets a torn record appended to the log,
+# as a crash halfway through a write would leave it. @DATA@ in the input names this directory and @WORK@ the scratch
+# directory WORK; both are written back as placeholders in the output. With UPDATE set, the output replaces EXPECTED.
+cmake_minimum_required(VERSION 3.10)
+get_filename_component(data ${INPUT} DIRECTORY)
+file(REMOVE_RECURSE ${WORK})
+file(MAKE_DIRECTORY ${WORK})
+file(READ ${INPUT} script)
+string(REPLACE "@DATA@" "${data}" script "${script}")
+string(REPLACE "@WORK@" "${WORK}" script "${script}")
+set(options)
+if (WAL)
+    set(options --wal ${WORK}/db.wal)
+endif ()
+
+set(output "")
+while (NOT script STREQUAL "")
+    string(FIND "${script}" "STOP\n" end)
+    if (end EQUAL -1)
+        string(LENGTH "${script}" end)
+        set(rest "")
+    else ()
+        math(EXPR next "${end} + 5")
+        string(SUBSTRING "${script}" ${next} -1 rest)
+    endif ()
+    string(SUBSTRING "${script}" 0 ${end} session)
+    set(script "${rest}")
+    if (session MATCHES "^TEAR\n")
+        string(SUBSTRING "${session}" 5 -1 session)
+        file(APPEND ${WORK}/db.wal "torn")
+    endif ()
+    file(WRITE ${WORK}/session.sql "${session}STOP\n")
+    execute_process(COMMAND ${MAIN} ${options} INPUT_FILE ${WORK}/session.sql OUTPUT_VARIABLE printed
+                    RESULT_VARIABLE result)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "${MAIN} exited with ${result}")
+    endif ()
+    string(APPEND output "${printed}")
+endwhile ()
+
+string(REPLACE "${WORK}" "@WORK@" output "${output}")
+string(REPLACE "${data}" "@DATA@" output "${output}")
+if (UPDATE)
+    file(WRITE ${EXPECTED} "${output}")
+endif ()
+file(READ ${EXPECTED} expected)
+if (NOT output STREQUAL expected)
+    message(FATAL_ERROR "Output differs from ${EXPECTED}:\n${output}")
+endif ()
@@ -0,0 +1,27 @@
+CREATE TABLE t (id INT, v TEXT, PRIMARY KEY(id));
+INSERT INTO t (id, v) VALUES (1, 'a'), (2, 'b');
+COMMIT;
+ROLLBACK;
+BEGIN;
+BEGIN;
+INSERT INTO t (id, v) VALUES (3, 'c');
+UPDATE t SET v = 'z' WHERE id = 1;
+DELETE FROM t WHERE id = 2;
+SELECT * FROM t ORDER BY id;
+ROLLBACK;
+SELECT * FROM t ORDER BY id;
+BEGIN TRANSACTION;
+DELETE FROM t WHERE id = 2;
+INSERT INTO t (id, v) VALUES (2, 'bb');
+INSERT INTO t (id, v) VALUES (2, 'dup');
+UPDATE t SET v = 'aa' WHERE id = 1;
+UPDATE t SET v = 'aaa' WHERE id = 1;
+SELECT * FROM t ORDER BY id;
+COMMIT;
+SELECT * FROM t ORDER BY id;
+BEGIN;
+INSERT INTO t (id, v) VALUES (4, 'd');
+DELETE FROM t WHERE id = 4;
+COMMIT;
+SELECT COUNT(*) FROM t;
+STOP
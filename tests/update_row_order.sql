@@ -0,0 +1,6 @@
+CREATE TABLE t (id INT, v TEXT, PRIMARY KEY(id));
+INSERT INTO t (id, v) VALUES (1, 'a'), (2, 'b'), (3, 'c');
+UPDATE t SET v = 'x' WHERE id = 1;
+SELECT * FROM t;
+SELECT * FROM t ORDER BY id;
+STOP
@@ -0,0 +1,27 @@
+CREATE TABLE accounts (id INT, owner TEXT, balance DOUBLE, active BOOL, PRIMARY KEY(id));
+INSERT INTO accounts (id, owner, balance, active) VALUES (1, 'ann', 10.5, TRUE), (2, 'bob', 20, FALSE), (3, 'cy', 0, TRUE);
+UPDATE accounts SET balance = 99.25 WHERE id = 2;
+DELETE FROM accounts WHERE id = 3;
+CREATE INDEX by_owner ON accounts (owner);
+CREATE TABLE scratch (x INT);
+DROP TABLE scratch;
+BEGIN;
+INSERT INTO accounts (id, owner, balance, active) VALUES (4, 'dee', 4, TRUE);
+UPDATE accounts SET owner = 'ann2' WHERE id = 1;
+COMMIT;
+BEGIN;
+INSERT INTO accounts (id, owner, balance, active) VALUES (5, 'eve', 5, FALSE);
+DELETE FROM accounts WHERE id = 4;
+ROLLBACK;
+INSERT INTO accounts (id, owner) VALUES (6, 'fay');
+STOP
+SELECT * FROM accounts ORDER BY id;
+SELECT * FROM accounts WHERE owner = 'dee';
+SELECT * FROM scratch;
+CREATE INDEX by_owner ON accounts (owner);
+DROP INDEX by_owner;
+UPDATE accounts SET active = FALSE WHERE id = 1;
+STOP
+SELECT * FROM accounts ORDER BY id;
+CREATE INDEX by_owner ON accounts (owner);
+STOP
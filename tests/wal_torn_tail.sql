@@ -0,0 +1,10 @@
+CREATE TABLE t (id INT, v TEXT, PRIMARY KEY(id));
+INSERT INTO t (id, v) VALUES (1, 'one'), (2, 'two');
+INSERT INTO t (id, v) VALUES (3, 'three');
+STOP
+TEAR
+SELECT * FROM t ORDER BY id;
+INSERT INTO t (id, v) VALUES (4, 'four');
+STOP
+SELECT * FROM t ORDER BY id;
+STOP